@@ -1,12 +1,290 @@
 #!/usr/bin/env python3
 import sys
 import os
+import io
+import argparse
 import struct
+import hashlib
+import zipfile
+import zlib
+
+try:
+    import lz4.block as lz4_block
+except ImportError:
+    lz4_block = None
 
 # 魔术字符串，用于标识附加的ZIP文件信息
 MAGIC_SIGNATURE = b'AUSIC_ZIP_INFO'
+TRAILER_SIZE = 14 + 8 + 8 + 4
+
+# 安装清单：位于ZIP数据和魔术字符串之间，安装程序据此跳过中央目录解析
+MANIFEST_MAGIC = b'AUSICMAN'
+MANIFEST_VERSION = 1
+MANIFEST_HEADER = struct.Struct('<8sHHIIQQ')    # magic, version, flags, dirs, entries, total compressed, total uncompressed
+MANIFEST_ENTRY = struct.Struct('<QQQQIHH16s')   # local header, data offset, compressed, uncompressed, crc, method, path length, hash
+CONTENT_HASH_SIZE = 16
+
+# 分帧格式（清单版本 2）：载荷是魔术字符串加上各文件按固定大小切分、分别压缩的 LZ4 块，
+# 清单条目的 local header 字段改为第一帧的序号，文件条目之后是帧表
+FRAMED_MANIFEST_VERSION = 2
+FRAMED_PAYLOAD_MAGIC = b'AUSICLZ4'
+FRAME_TABLE_HEADER = struct.Struct('<II')       # frame size, frame count
+FRAME_STORED_FLAG = 0x80000000
+METHOD_LZ4_FRAMES = 0x4c34
+DEFAULT_FRAME_SIZE = 256 * 1024
+MAX_FRAME_SIZE = 16 * 1024 * 1024
+
+LOCAL_HEADER = struct.Struct('<IHHHHHIIIHH')
+
+# 整体校验块：紧挨在魔术字符串之前，覆盖载荷和安装清单。
+# 按叶子大小切分，每个叶子求 BLAKE2b-256，根哈希 = BLAKE2b-256(叶子大小, 总长度, 各叶子哈希)
+CHECKSUM_MAGIC = b'AUSICSUM'
+CHECKSUM_BLOCK = struct.Struct('<8sIIQ32s')    # magic, leaf size, reserved, covered size, root hash
+CHECKSUM_LEAF_SIZE = 4 * 1024 * 1024
+
+
+def normalize_path(name):
+    """Normalize an entry name the same way the installer does"""
+    path = name.replace('\\', '/')
+    while path.startswith('./') or path.startswith('/'):
+        path = path[1:] if path.startswith('/') else path[2:]
+    return path.rstrip('/')
+
+
+def is_directory(info):
+    if info.filename.endswith('/') or info.filename.endswith('\\'):
+        return True
+    if info.create_system == 0 and info.external_attr & 0x10:
+        return True
+    return info.create_system == 3 and (info.external_attr >> 16) & 0o170000 == 0o040000
+
+
+def content_hash_of(data):
+    return hashlib.blake2b(data, digest_size=CONTENT_HASH_SIZE).digest()
+
+
+def deduplicate_zip(zip_data):
+    """Store byte-identical files only once.
+
+    Returns the rewritten ZIP data and a dict mapping each kept file name to the
+    names of its removed copies. The copies are listed in the install manifest
+    with the kept file's data offsets, so the installer still creates them.
+    """
+    duplicates = {}
+    first_by_content = {}
+
+    with zipfile.ZipFile(io.BytesIO(zip_data)) as zf:
+        infos = sorted(zf.infolist(), key=lambda i: i.header_offset)
+        for info in infos:
+            if is_directory(info) or info.file_size == 0:
+                continue
+            key = (info.file_size, content_hash_of(zf.read(info)))
+            if key in first_by_content:
+                duplicates.setdefault(first_by_content[key], []).append(info.filename)
+            else:
+                first_by_content[key] = info.filename
+
+        if not duplicates:
+            return zip_data, duplicates
+
+        removed = {name for copies in duplicates.values() for name in copies}
+        output = io.BytesIO()
+        with zipfile.ZipFile(output, 'w', allowZip64=True) as out:
+            for info in infos:
+                if info.filename in removed:
+                    continue
+                kept = zipfile.ZipInfo(info.filename, info.date_time)
+                kept.external_attr = info.external_attr
+                kept.create_system = info.create_system
+                kept.compress_type = info.compress_type
+                out.writestr(kept, zf.read(info), compresslevel=9)
+        return output.getvalue(), duplicates
+
+
+def _lz4_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def _lz4_sequence(out, literals, offset=0, match_length=0):
+    literal_length = len(literals)
+    token = min(literal_length, 15) << 4
+    if offset:
+        token |= min(match_length - 4, 15)
+    out.append(token)
+    if literal_length >= 15:
+        _lz4_length(out, literal_length - 15)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if match_length - 4 >= 15:
+            _lz4_length(out, match_length - 4 - 15)
+
+
+def lz4_compress_block(data):
+    """Compress data as a raw LZ4 block (no frame header)"""
+    if lz4_block is not None:
+        return lz4_block.compress(data, mode='high_compression', store_size=False)
+
+    # 纯 Python 的贪心实现：4 字节哈希查找最近一次出现的位置。
+    # 遵守 LZ4 的结尾规则：最后 5 个字节必须是字面量，最后一个匹配至少在结尾前 12 字节开始
+    size = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+    while pos < size - 12:
+        key = data[pos:pos + 4]
+        candidate = table.get(key)
+        table[key] = pos
+        if candidate is None or pos - candidate > 65535:
+            pos += 1
+            continue
+
+        length = 4
+        limit = size - 5 - pos
+        while length < limit and data[candidate + length] == data[pos + length]:
+            length += 1
+        _lz4_sequence(out, data[anchor:pos], pos - candidate, length)
+        pos += length
+        anchor = pos
+    _lz4_sequence(out, data[anchor:])
+    return bytes(out)
+
 
-def append_zip_to_exe(exe_path, zip_path):
+def pack_manifest(version, directories, entries):
+    """Serialize the manifest header, directory list and file entries
+
+    Each entry is (header offset, data offset, compressed size, uncompressed size,
+    crc, method, path, content hash).
+    """
+    total_compressed = sum(entry[2] for entry in entries)
+    total_uncompressed = sum(entry[3] for entry in entries)
+
+    manifest = bytearray(MANIFEST_HEADER.pack(MANIFEST_MAGIC, version, 0,
+                                              len(directories), len(entries),
+                                              total_compressed, total_uncompressed))
+    for directory in sorted(directories):
+        name = directory.encode('utf-8')
+        manifest += struct.pack('<H', len(name)) + name
+    for header_offset, data_offset, compressed, uncompressed, crc, method, path, content_hash in entries:
+        name = path.encode('utf-8')
+        manifest += MANIFEST_ENTRY.pack(header_offset, data_offset, compressed, uncompressed,
+                                        crc, method, len(name), content_hash)
+        manifest += name
+    return manifest
+
+
+def add_parents(directories, path):
+    parent = os.path.dirname(path)
+    while parent:
+        directories.add(parent)
+        parent = os.path.dirname(parent)
+
+
+def build_framed_payload(zip_data, dedup=False, frame_size=DEFAULT_FRAME_SIZE):
+    """Recompress a ZIP archive into the framed LZ4 payload
+
+    Returns (payload, manifest). Every file is split into frame_size frames that
+    are compressed independently, so the installer can decode any frame on its
+    own and spread a large file over several threads.
+    """
+    if not 0 < frame_size <= MAX_FRAME_SIZE:
+        raise ValueError(f'Frame size must be between 1 and {MAX_FRAME_SIZE}')
+
+    payload = bytearray(FRAMED_PAYLOAD_MAGIC)
+    frame_sizes = []
+    directories = set()
+    entries = []
+    first_by_content = {}
+
+    with zipfile.ZipFile(io.BytesIO(zip_data)) as zf:
+        for info in sorted(zf.infolist(), key=lambda i: i.header_offset):
+            path = normalize_path(info.filename)
+            if not path:
+                continue
+            if is_directory(info):
+                directories.add(path)
+                continue
+            add_parents(directories, path)
+
+            data = zf.read(info)
+            content_hash = content_hash_of(data)
+            key = (len(data), content_hash)
+
+            # 内容相同的文件共用同一组帧
+            if dedup and data and key in first_by_content:
+                first_frame, data_offset, compressed = first_by_content[key]
+            else:
+                first_frame, data_offset = len(frame_sizes), len(payload)
+                for start in range(0, len(data), frame_size):
+                    chunk = data[start:start + frame_size]
+                    block = lz4_compress_block(chunk)
+                    if len(block) >= len(chunk):
+                        payload += chunk
+                        frame_sizes.append(len(chunk) | FRAME_STORED_FLAG)
+                    else:
+                        payload += block
+                        frame_sizes.append(len(block))
+                compressed = len(payload) - data_offset
+                first_by_content.setdefault(key, (first_frame, data_offset, compressed))
+
+            entries.append((first_frame, data_offset, compressed, len(data),
+                            zlib.crc32(data) & 0xffffffff, METHOD_LZ4_FRAMES, path, content_hash))
+
+    manifest = pack_manifest(FRAMED_MANIFEST_VERSION, directories, entries)
+    manifest += FRAME_TABLE_HEADER.pack(frame_size, len(frame_sizes))
+    manifest += struct.pack(f'<{len(frame_sizes)}I', *frame_sizes)
+    return bytes(payload), bytes(manifest)
+
+
+def tree_hash(data, leaf_size=CHECKSUM_LEAF_SIZE):
+    """Root of the two-level BLAKE2b-256 tree the installer verifies in parallel"""
+    root = hashlib.blake2b(struct.pack('<IQ', leaf_size, len(data)), digest_size=32)
+    view = memoryview(data)
+    for start in range(0, len(data), leaf_size):
+        root.update(hashlib.blake2b(view[start:start + leaf_size], digest_size=32).digest())
+    return root.digest()
+
+
+def build_checksum(covered, leaf_size=CHECKSUM_LEAF_SIZE):
+    return CHECKSUM_BLOCK.pack(CHECKSUM_MAGIC, leaf_size, 0, len(covered), tree_hash(covered, leaf_size))
+
+
+def build_manifest(zip_data, duplicates=None):
+    """Build the binary install manifest for a ZIP archive"""
+    directories = set()
+    entries = []
+    duplicates = duplicates or {}
+
+    with zipfile.ZipFile(io.BytesIO(zip_data)) as zf:
+        for info in sorted(zf.infolist(), key=lambda i: i.header_offset):
+            path = normalize_path(info.filename)
+            if not path:
+                continue
+            if is_directory(info):
+                directories.add(path)
+                continue
+
+            # 数据偏移以本地文件头为准，扩展字段长度可能和中央目录不同
+            header = LOCAL_HEADER.unpack_from(zip_data, info.header_offset)
+            if header[0] != 0x04034b50:
+                raise ValueError(f'Bad local header for {info.filename}')
+            data_offset = info.header_offset + LOCAL_HEADER.size + header[9] + header[10]
+
+            content_hash = content_hash_of(zf.read(info))
+            paths = [path] + [normalize_path(name) for name in duplicates.get(info.filename, [])]
+            for entry_path in paths:
+                # 去重后的副本和首个文件共用同一段压缩数据
+                entries.append((info.header_offset, data_offset, info.compress_size, info.file_size,
+                                info.CRC, info.compress_type, entry_path, content_hash))
+                add_parents(directories, entry_path)
+
+    return bytes(pack_manifest(MANIFEST_VERSION, directories, entries))
+
+def append_zip_to_exe(exe_path, zip_path, dedup=False, payload_format='zip', frame_size=DEFAULT_FRAME_SIZE):
     """Append zip file content to exe file with metadata"""
     
     # Check if files exist
@@ -28,22 +306,45 @@ def append_zip_to_exe(exe_path, zip_path):
             print(f"Error: {zip_path} is not a valid ZIP file")
             return False
         
+        if payload_format == 'lz4':
+            # Recompress into independently decodable LZ4 frames; the manifest carries the frame table
+            original_zip_size = len(zip_data)
+            zip_data, manifest = build_framed_payload(zip_data, dedup, frame_size)
+            print(f"Framed LZ4 payload: {original_zip_size} -> {len(zip_data)} bytes, frame size {frame_size}")
+        else:
+            # Store identical files once; the manifest still lists every copy
+            duplicates = {}
+            if dedup:
+                original_zip_size = len(zip_data)
+                zip_data, duplicates = deduplicate_zip(zip_data)
+                copies = sum(len(names) for names in duplicates.values())
+                print(f"Deduplicated {copies} files, ZIP size {original_zip_size} -> {len(zip_data)}")
+            manifest = build_manifest(zip_data, duplicates)
+        
         # Get original exe size before appending
         original_size = os.path.getsize(exe_path)
         zip_size = len(zip_data)
         
+        # Tree hash over payload + manifest, checked before the installer touches the disk
+        checksum = build_checksum(zip_data + manifest)
+        
         # Create metadata structure:
-        # - ZIP data (variable length)
+        # - ZIP data or framed LZ4 payload (variable length)
+        # - Install manifest (variable length, see MANIFEST_HEADER / MANIFEST_ENTRY)
+        # - Checksum block (56 bytes, see CHECKSUM_BLOCK)
         # - Magic signature (14 bytes): "AUSIC_ZIP_INFO"
         # - ZIP offset (8 bytes, little-endian): where ZIP data starts
         # - ZIP size (8 bytes, little-endian): size of ZIP data
-        # - Metadata size (4 bytes, little-endian): size of this metadata block
+        # - Metadata size (4 bytes, little-endian): size of manifest + checksum + this trailer,
+        #   34 for old packages without a manifest
         
-        metadata = struct.pack('<QQI', original_size, zip_size, 14 + 8 + 8 + 4)
+        metadata = struct.pack('<QQI', original_size, zip_size, TRAILER_SIZE + len(manifest) + len(checksum))
         
-        # Append to exe file: ZIP data + magic + metadata
+        # Append to exe file: ZIP data + manifest + checksum + magic + metadata
         with open(exe_path, 'ab') as exe_file:
             exe_file.write(zip_data)  # ZIP data
+            exe_file.write(manifest)  # Install manifest
+            exe_file.write(checksum)  # Whole-payload checksum
             exe_file.write(MAGIC_SIGNATURE)  # Magic signature
             exe_file.write(metadata)  # Metadata (offset, size, metadata_size)
         
@@ -51,6 +352,7 @@ def append_zip_to_exe(exe_path, zip_path):
         print(f"Original exe size: {original_size}")
         print(f"ZIP starts at offset: {original_size}")
         print(f"ZIP size: {zip_size}")
+        print(f"Manifest size: {len(manifest)}")
         print(f"Metadata appended with magic signature: {MAGIC_SIGNATURE.decode('ascii')}")
         return True
         
@@ -59,12 +361,16 @@ def append_zip_to_exe(exe_path, zip_path):
         return False
 
 if __name__ == "__main__":
-    if len(sys.argv) != 3:
-        print("Usage: python append_zip.py <exe_path> <zip_path>")
-        sys.exit(1)
-    
-    exe_path = sys.argv[1]
-    zip_path = sys.argv[2]
+    parser = argparse.ArgumentParser(description="Append a ZIP payload and install manifest to the installer")
+    parser.add_argument("exe_path")
+    parser.add_argument("zip_path")
+    parser.add_argument("--dedup", action="store_true",
+                        help="store byte-identical files only once (requires the manifest-aware installer)")
+    parser.add_argument("--format", choices=("zip", "lz4"), default="zip",
+                        help="payload format: the ZIP itself, or files recompressed into seekable LZ4 frames")
+    parser.add_argument("--frame-size", type=int, default=DEFAULT_FRAME_SIZE,
+                        help="uncompressed size of each LZ4 frame (lz4 format only)")
+    args = parser.parse_args()
     
-    success = append_zip_to_exe(exe_path, zip_path)
+    success = append_zip_to_exe(args.exe_path, args.zip_path, args.dedup, args.format, args.frame_size)
     sys.exit(0 if success else 1)
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "backgroundremover.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// <linux/ioprio.h> 在较旧的系统头文件中没有，这里直接定义
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_CLASS_IDLE = 3;
+const int IOPRIO_CLASS_SHIFT = 13;
+#endif
+
+void lowerCurrentThreadPriority()
+{
+#if defined(Q_OS_WIN)
+    // 后台模式同时降低 CPU、磁盘和内存优先级
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(Q_OS_LINUX)
+    // 磁盘 I/O 使用 idle 调度类，只在磁盘空闲时执行；id 为 0 时只作用于当前线程
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+} // namespace
+
+const char BackgroundRemover::TRASH_DIR_NAME[] = ".ausic_trash";
+
+BackgroundRemover::BackgroundRemover(const QString &targetDir)
+    : m_targetDir(QDir(targetDir).absolutePath())
+    , m_moved(0)
+    , m_nextItem(0)
+    , m_stopping(0)
+{
+    // 每次安装单独一个批次目录，名字带上时间和进程号，不会和遗留的批次冲突
+    m_trashDir = m_targetDir + QLatin1Char('/') + QLatin1String(TRASH_DIR_NAME);
+    m_batchDir = m_trashDir + QStringLiteral("/%1-%2")
+                                  .arg(QDateTime::currentMSecsSinceEpoch())
+                                  .arg(QCoreApplication::applicationPid());
+}
+
+BackgroundRemover::~BackgroundRemover()
+{
+    m_stopping.storeRelaxed(1);
+    wait();
+}
+
+bool BackgroundRemover::moveAside(const QString &path)
+{
+    if (m_moved == 0 && !QDir().mkpath(m_batchDir)) {
+        return false;
+    }
+
+    // 回收目录中只用序号命名，不需要重建原来的目录层次
+    QString source = QDir(m_targetDir).absoluteFilePath(path);
+    QString target = m_batchDir + QLatin1Char('/') + QString::number(m_moved);
+    if (!QDir().rename(source, target)) {
+        return false;
+    }
+    m_moved++;
+    return true;
+}
+
+int BackgroundRemover::movedCount() const
+{
+    return m_moved;
+}
+
+void BackgroundRemover::start(int threadCount)
+{
+    if (!m_workers.isEmpty()) {
+        return;
+    }
+
+    QDir trash(m_trashDir);
+    if (!trash.exists()) {
+        return;
+    }
+
+    // 各批次中的条目互不相关，按条目分给各线程
+    m_items.clear();
+    const QStringList batches = trash.entryList(QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+    for (const QString &batch : batches) {
+        QDir batchDir(trash.filePath(batch));
+        const QStringList items = batchDir.entryList(QDir::AllEntries | QDir::Hidden | QDir::System
+                                                     | QDir::NoDotAndDotDot);
+        for (const QString &item : items) {
+            m_items.append(batchDir.filePath(item));
+        }
+    }
+
+    // 删除只是回收空间，最多用一半的线程，不和解压争抢
+    int workerCount = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    workerCount = qMax(1, qMin(workerCount / 2, int(m_items.size())));
+    m_nextItem.storeRelaxed(0);
+    m_stopping.storeRelaxed(0);
+    for (int i = 0; i < workerCount; i++) {
+        QThread *thread = QThread::create([this]() {
+            lowerCurrentThreadPriority();
+            forever {
+                int item = m_nextItem.fetchAndAddRelaxed(1);
+                if (item >= m_items.size() || m_stopping.loadRelaxed() != 0) {
+                    break;
+                }
+                removeItem(m_items.at(item));
+            }
+        });
+        m_workers.append(thread);
+        thread->start(QThread::LowestPriority);
+    }
+}
+
+bool BackgroundRemover::wait()
+{
+    for (QThread *thread : std::as_const(m_workers)) {
+        thread->wait();
+        delete thread;
+    }
+    m_workers.clear();
+
+    // 内容删完后批次目录和回收目录都是空的；中途停止时 rmdir 失败，留给下次
+    QDir trash(m_trashDir);
+    if (!trash.exists()) {
+        return true;
+    }
+    const QStringList batches = trash.entryList(QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+    for (const QString &batch : batches) {
+        trash.rmdir(batch);
+    }
+    return QDir(m_targetDir).rmdir(QLatin1String(TRASH_DIR_NAME));
+}
+
+void BackgroundRemover::removeItem(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.isDir() || info.isSymLink()) {
+        QFile::remove(path);
+        return;
+    }
+
+    // 逐个删除文件，停止时可以在文件之间退出；剩下的空目录最后一起删除
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext() && m_stopping.loadRelaxed() == 0) {
+        QFile::remove(it.next());
+    }
+    if (m_stopping.loadRelaxed() == 0) {
+        QDir(path).removeRecursively();
+    }
+}
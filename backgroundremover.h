@@ -0,0 +1,49 @@
+#ifndef BACKGROUNDREMOVER_H
+#define BACKGROUNDREMOVER_H
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QThread;
+
+// 删除旧文件不再阻塞安装：先把它们改名移到安装目录下的回收目录（同一个卷，只是一次 rename），
+// 解压立即开始；低优先级的后台线程并行删除回收目录中的内容。
+// 安装程序退出前等待删除完成；被强行结束时没删完的部分留在回收目录里，下次启动时一起删除
+class BackgroundRemover
+{
+public:
+    explicit BackgroundRemover(const QString &targetDir);
+
+    // 停止后台删除并等待线程退出，剩余内容留给下次
+    ~BackgroundRemover();
+
+    // 把 path（相对安装目录，或同一个卷上的绝对路径）移入回收目录；
+    // 失败（例如文件被占用）时返回 false，由调用方直接删除
+    bool moveAside(const QString &path);
+    int movedCount() const;
+
+    // 开始在后台删除回收目录，包括以前遗留的内容；0 表示按 CPU 核数选择线程数
+    void start(int threadCount);
+
+    // 等待后台删除完成，返回回收目录是否已经删干净
+    bool wait();
+
+    static const char TRASH_DIR_NAME[];
+
+private:
+    void removeItem(const QString &path);
+
+    QString m_targetDir;
+    QString m_trashDir;
+    QString m_batchDir;     // 本次安装移入的内容，和以前遗留的批次分开
+    int m_moved;
+
+    QStringList m_items;
+    QAtomicInteger<int> m_nextItem;
+    QAtomicInteger<int> m_stopping;
+    QVector<QThread *> m_workers;
+};
+
+#endif // BACKGROUNDREMOVER_H
@@ -0,0 +1,484 @@
+// ausic_bench：不经过界面和 Installer，直接驱动安装器的各个组件，
+// 在 bench_payload.py 生成的合成安装包上测量定位、映射、索引、校验和解压的速度，
+// 结果（MB/s、文件/s、系统调用次数、峰值内存）以 JSON 输出到标准输出，便于比较不同版本。
+// 只依赖 Qt Core，可以在没有图形环境的 Linux 上运行
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "extractionengine.h"
+#include "filewritebackend.h"
+#include "payloaddevice.h"
+#include "payloadlocator.h"
+#include "memorybudget.h"
+#include "payloadverifier.h"
+#include "progresstracker.h"
+#include "zipindex.h"
+
+namespace {
+
+const char *const SCENARIOS[] = { "tiny", "huge", "incompressible", "deep" };
+const char *const FORMATS[] = { "zip", "lz4" };
+const int PAGE_SIZE = 4096;
+
+// 按页读取的结果写到这里，避免编译器把读取优化掉
+volatile quint64 g_sink = 0;
+
+// 进程级的资源计数，只在 Linux 上可用，其他平台返回 -1
+struct ResourceUsage {
+    qint64 readCalls = -1;      // /proc/self/io 的 syscr：read 类系统调用次数（包括已退出的线程）
+    qint64 writeCalls = -1;     // syscw：write 类系统调用次数
+    qint64 peakRssKb = -1;      // /proc/self/status 的 VmHWM
+
+    static ResourceUsage current()
+    {
+        ResourceUsage usage;
+        QFile io(QStringLiteral("/proc/self/io"));
+        if (io.open(QIODevice::ReadOnly)) {
+            for (const QByteArray &line : io.readAll().split('\n')) {
+                if (line.startsWith("syscr:")) {
+                    usage.readCalls = line.mid(6).trimmed().toLongLong();
+                } else if (line.startsWith("syscw:")) {
+                    usage.writeCalls = line.mid(6).trimmed().toLongLong();
+                }
+            }
+        }
+        QFile status(QStringLiteral("/proc/self/status"));
+        if (status.open(QIODevice::ReadOnly)) {
+            for (const QByteArray &line : status.readAll().split('\n')) {
+                if (line.startsWith("VmHWM:")) {
+                    usage.peakRssKb = line.mid(6).trimmed().split(' ').value(0).toLongLong();
+                }
+            }
+        }
+        return usage;
+    }
+
+    // 把峰值内存重置为当前值，每个用例单独统计自己的峰值
+    static void resetPeak()
+    {
+        QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+        if (clearRefs.open(QIODevice::WriteOnly)) {
+            clearRefs.write("5");
+        }
+    }
+};
+
+// 一个用例的一次运行：返回是否成功，bytes/files 为本次处理的数据量
+struct RunResult {
+    bool ok = false;
+    qint64 bytes = 0;
+    qint64 files = 0;
+    qint64 bufferAllocations = -1;  // 解压缓冲池的分配次数，只有 extract 用例有
+};
+
+struct Payload {
+    QString scenario;
+    QString format;
+    QString path;           // 带末尾元数据的安装包
+    QString plainPath;      // 只拼接了 ZIP 的安装包，没有时为空
+    qint64 offset = 0;
+    qint64 size = 0;
+    QByteArray manifest;
+    PayloadChecksum checksum;
+    ZipIndex index;
+    qint64 totalBytes = 0;
+    qint64 totalFiles = 0;
+};
+
+class Bench
+{
+public:
+    Bench(int repeat, int threadCount, FileWriteBackend::Kind backend, qint64 memoryBudget, const QString &workDir)
+        : m_repeat(repeat), m_threadCount(threadCount), m_backend(backend), m_memoryBudget(memoryBudget),
+          m_workDir(workDir)
+    {
+    }
+
+    bool preparePayload(Payload &payload);
+    void runAll(Payload &payload);
+
+    QJsonArray results() const { return m_results; }
+
+private:
+    // cleanup 在每次运行计时结束后调用，例如删除解压结果
+    void runCase(const Payload &payload, const QString &name, const std::function<RunResult()> &run,
+                 const std::function<void()> &cleanup = std::function<void()>());
+
+    RunResult locate(const QString &path);
+    RunResult mapPayload(const Payload &payload);
+    RunResult indexCentralDirectory(const Payload &payload);
+    RunResult indexManifest(const Payload &payload);
+    RunResult verify(const Payload &payload);
+    RunResult extract(const Payload &payload, const QString &targetDir, int threadCount);
+
+    int m_repeat;
+    int m_threadCount;
+    FileWriteBackend::Kind m_backend;
+    qint64 m_memoryBudget;
+    QString m_workDir;
+    QJsonArray m_results;
+};
+
+bool Bench::preparePayload(Payload &payload)
+{
+    PayloadLocator locator(payload.path);
+    if (!locator.locate(payload.offset, payload.size)) {
+        return false;
+    }
+    payload.manifest = locator.manifest();
+    payload.checksum = locator.checksum();
+
+    // 条目列表和数据量从安装包本身得到，与生成脚本的参数无关
+    bool indexed = !payload.manifest.isEmpty() && payload.index.loadManifest(payload.manifest, payload.size);
+    if (!indexed) {
+        PayloadDevice device(payload.path, payload.offset, payload.size);
+        indexed = device.open(QIODevice::ReadOnly) && payload.index.load(&device);
+    }
+    if (!indexed) {
+        return false;
+    }
+    for (const ZipEntry &entry : payload.index.entries()) {
+        if (!entry.isDir) {
+            payload.totalBytes += entry.uncompressedSize;
+            payload.totalFiles++;
+        }
+    }
+    return true;
+}
+
+void Bench::runAll(Payload &payload)
+{
+    runCase(payload, QStringLiteral("locate_trailer"), [&]() { return locate(payload.path); });
+    if (!payload.plainPath.isEmpty()) {
+        runCase(payload, QStringLiteral("locate_scan"), [&]() { return locate(payload.plainPath); });
+    }
+    runCase(payload, QStringLiteral("payload_map"), [&]() { return mapPayload(payload); });
+    if (!payload.index.isFramed()) {
+        runCase(payload, QStringLiteral("index_central_directory"), [&]() { return indexCentralDirectory(payload); });
+    }
+    if (!payload.manifest.isEmpty()) {
+        runCase(payload, QStringLiteral("index_manifest"), [&]() { return indexManifest(payload); });
+    }
+    if (payload.checksum.isValid()) {
+        runCase(payload, QStringLiteral("verify"), [&]() { return verify(payload); });
+    }
+    QString targetDir = QDir(m_workDir).filePath(
+        QStringLiteral("extract-%1-%2").arg(payload.scenario, payload.format));
+    runCase(payload, QStringLiteral("extract"), [&]() { return extract(payload, targetDir, m_threadCount); },
+            [&]() { QDir(targetDir).removeRecursively(); });
+
+    // 分帧载荷中超过一段的文件由多个线程同时打开、写入各自的区间；
+    // 单核机器上 --threads 0 只有一个线程，这里至少用两个线程覆盖并发打开同一个文件的路径
+    bool segmented = false;
+    for (const ZipEntry &entry : payload.index.entries()) {
+        segmented = segmented || (!entry.isDir && entry.uncompressedSize > ExtractionEngine::SEGMENT_SIZE);
+    }
+    if (payload.index.isFramed() && segmented) {
+        int threads = qMax(2, m_threadCount > 0 ? m_threadCount : QThread::idealThreadCount());
+        runCase(payload, QStringLiteral("extract_segmented"), [&]() { return extract(payload, targetDir, threads); },
+                [&]() { QDir(targetDir).removeRecursively(); });
+    }
+}
+
+void Bench::runCase(const Payload &payload, const QString &name, const std::function<RunResult()> &run,
+                    const std::function<void()> &cleanup)
+{
+    // 每次运行单独计时，取中位数，避免偶发的调度抖动影响结果
+    QVector<qint64> times;
+    RunResult last;
+    ResourceUsage::resetPeak();
+    ResourceUsage before = ResourceUsage::current();
+    for (int i = 0; i < m_repeat; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        last = run();
+        times.append(timer.nsecsElapsed());
+        if (cleanup) {
+            cleanup();
+        }
+        if (!last.ok) {
+            break;
+        }
+    }
+    ResourceUsage after = ResourceUsage::current();
+    std::sort(times.begin(), times.end());
+
+    double ms = times.at(times.size() / 2) / 1e6;
+    double seconds = ms / 1000.0;
+    QJsonObject result;
+    result[QStringLiteral("scenario")] = payload.scenario;
+    result[QStringLiteral("format")] = payload.format;
+    result[QStringLiteral("case")] = name;
+    result[QStringLiteral("ok")] = last.ok;
+    result[QStringLiteral("runs")] = times.size();
+    result[QStringLiteral("ms")] = ms;
+    result[QStringLiteral("minMs")] = times.first() / 1e6;
+    result[QStringLiteral("bytes")] = last.bytes;
+    result[QStringLiteral("files")] = last.files;
+    result[QStringLiteral("mbPerSec")] = seconds > 0 ? last.bytes / seconds / (1024.0 * 1024.0) : 0.0;
+    result[QStringLiteral("filesPerSec")] = seconds > 0 ? last.files / seconds : 0.0;
+    // 系统调用次数按每次运行平均
+    if (before.readCalls >= 0 && after.readCalls >= 0) {
+        result[QStringLiteral("readSyscalls")] = (after.readCalls - before.readCalls) / times.size();
+        result[QStringLiteral("writeSyscalls")] = (after.writeCalls - before.writeCalls) / times.size();
+    }
+    if (after.peakRssKb >= 0) {
+        result[QStringLiteral("peakRssKb")] = after.peakRssKb;
+    }
+    if (last.bufferAllocations >= 0) {
+        result[QStringLiteral("bufferAllocations")] = last.bufferAllocations;
+    }
+    m_results.append(result);
+
+    QTextStream(stderr) << payload.scenario << '/' << payload.format << ' ' << name << ": "
+                        << (last.ok ? QString::number(ms, 'f', 2) + QStringLiteral(" ms") : QStringLiteral("FAILED"))
+                        << Qt::endl;
+}
+
+RunResult Bench::locate(const QString &path)
+{
+    RunResult result;
+    qint64 offset = 0;
+    qint64 size = 0;
+    PayloadLocator locator(path);
+    result.ok = locator.locate(offset, size);
+    result.bytes = QFileInfo(path).size();
+    return result;
+}
+
+RunResult Bench::mapPayload(const Payload &payload)
+{
+    // 以前安装前要把压缩包复制到临时文件，现在直接映射 exe 中的区间；
+    // 这里映射后按页读一遍，测量的是冷/热缓存下把载荷读进内存的代价
+    RunResult result;
+    PayloadDevice device(payload.path, payload.offset, payload.size);
+    if (!device.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+    quint64 sum = 0;
+    if (const uchar *data = device.data()) {
+        for (qint64 pos = 0; pos < payload.size; pos += PAGE_SIZE) {
+            sum += data[pos];
+        }
+    } else {
+        QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+        qint64 count;
+        while ((count = device.read(buffer.data(), buffer.size())) > 0) {
+            sum += uchar(buffer.at(0));
+        }
+    }
+    g_sink = g_sink + sum;
+    result.ok = true;
+    result.bytes = payload.size;
+    return result;
+}
+
+RunResult Bench::indexCentralDirectory(const Payload &payload)
+{
+    RunResult result;
+    PayloadDevice device(payload.path, payload.offset, payload.size);
+    ZipIndex index;
+    result.ok = device.open(QIODevice::ReadOnly) && index.load(&device);
+    result.files = index.entries().size();
+    return result;
+}
+
+RunResult Bench::indexManifest(const Payload &payload)
+{
+    RunResult result;
+    ZipIndex index;
+    result.ok = index.loadManifest(payload.manifest, payload.size);
+    result.bytes = payload.manifest.size();
+    result.files = index.entries().size();
+    return result;
+}
+
+RunResult Bench::verify(const Payload &payload)
+{
+    RunResult result;
+    PayloadVerifier verifier(payload.path, payload.offset, payload.checksum);
+    verifier.setMemoryBudget(m_memoryBudget);
+    verifier.start(m_threadCount);
+    result.ok = verifier.wait();
+    result.bytes = payload.checksum.coveredSize;
+    return result;
+}
+
+RunResult Bench::extract(const Payload &payload, const QString &targetDir, int threadCount)
+{
+    RunResult result;
+    PayloadDevice device(payload.path, payload.offset, payload.size);
+    if (!device.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+    // 与 Installer 的设置一致：进度统计照常进行，只是不汇报
+    ProgressTracker progress;
+    progress.reset(payload.index.entries());
+    ExtractionEngine engine(&device);
+    engine.setThreadCount(threadCount);
+    engine.setWriteBackend(m_backend);
+    engine.setMemoryBudget(m_memoryBudget);
+    if (payload.index.isFramed()) {
+        engine.setFrameTable(&payload.index.frames());
+    }
+    engine.setProgressTracker(&progress);
+    result.ok = engine.extract(payload.index.entries(), targetDir);
+    result.bufferAllocations = engine.bufferStats().allocations;
+    result.bytes = payload.totalBytes;
+    result.files = payload.totalFiles;
+    return result;
+}
+
+// 用 bench_payload.py 生成安装包；同一个工作目录下已经生成过的直接复用
+bool generatePayload(const QString &python, const QString &payloadDir, double scale, Payload &payload)
+{
+    QDir dir(payloadDir);
+    payload.path = dir.filePath(QStringLiteral("%1-%2.bin").arg(payload.scenario, payload.format));
+    QString plainPath = dir.filePath(QStringLiteral("%1-%2.notrailer.bin").arg(payload.scenario, payload.format));
+
+    if (!QFileInfo::exists(payload.path)) {
+        QTextStream(stderr) << "generating " << payload.scenario << '/' << payload.format << "..." << Qt::endl;
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(python, { QStringLiteral(AUSIC_BENCH_DIR "/bench_payload.py"),
+                                QStringLiteral("--scenario"), payload.scenario,
+                                QStringLiteral("--format"), payload.format,
+                                QStringLiteral("--output"), payloadDir,
+                                QStringLiteral("--scale"), QString::number(scale) });
+        if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            QTextStream(stderr) << "failed to generate " << payload.scenario << '/' << payload.format << Qt::endl;
+            return false;
+        }
+    }
+    if (QFileInfo::exists(plainPath)) {
+        payload.plainPath = plainPath;
+    }
+    return QFileInfo::exists(payload.path);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ausic_bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Benchmark the Ausic installer's payload pipeline on synthetic payloads"));
+    parser.addHelpOption();
+    QCommandLineOption scenarioOption(QStringLiteral("scenario"),
+        QStringLiteral("Scenario to run: tiny, huge, incompressible or deep (repeatable, default: all)"),
+        QStringLiteral("name"));
+    QCommandLineOption formatOption(QStringLiteral("format"),
+        QStringLiteral("Payload format: zip or lz4 (repeatable, default: both)"), QStringLiteral("format"));
+    QCommandLineOption scaleOption(QStringLiteral("scale"),
+        QStringLiteral("Multiplies file counts and sizes of the generated payloads"), QStringLiteral("factor"),
+        QStringLiteral("1"));
+    QCommandLineOption repeatOption(QStringLiteral("repeat"),
+        QStringLiteral("Runs per case; the median is reported"), QStringLiteral("count"), QStringLiteral("3"));
+    QCommandLineOption threadsOption(QStringLiteral("threads"),
+        QStringLiteral("Worker threads for verification and extraction (0 = CPU count)"), QStringLiteral("count"),
+        QStringLiteral("0"));
+    QCommandLineOption backendOption(QStringLiteral("write-backend"),
+        QStringLiteral("File write backend for extraction: portable or io_uring"), QStringLiteral("kind"),
+        QStringLiteral("portable"));
+    QCommandLineOption maxMemoryOption(QStringLiteral("max-memory"),
+        QStringLiteral("Memory budget for verification and extraction buffers, e.g. 256M (0 = unlimited)"),
+        QStringLiteral("size"), QStringLiteral("0"));
+    QCommandLineOption workDirOption(QStringLiteral("work-dir"),
+        QStringLiteral("Directory for generated payloads and extraction output; payloads are reused between runs"),
+        QStringLiteral("dir"));
+    QCommandLineOption pythonOption(QStringLiteral("python"),
+        QStringLiteral("Python interpreter used to generate payloads"), QStringLiteral("path"),
+        QStringLiteral(AUSIC_PYTHON));
+    parser.addOptions({ scenarioOption, formatOption, scaleOption, repeatOption, threadsOption, backendOption,
+                        maxMemoryOption, workDirOption, pythonOption });
+    parser.process(app);
+
+    QStringList scenarios = parser.values(scenarioOption);
+    if (scenarios.isEmpty()) {
+        for (const char *scenario : SCENARIOS) {
+            scenarios.append(QString::fromLatin1(scenario));
+        }
+    }
+    QStringList formats = parser.values(formatOption);
+    if (formats.isEmpty()) {
+        for (const char *format : FORMATS) {
+            formats.append(QString::fromLatin1(format));
+        }
+    }
+    bool ok = false;
+    double scale = parser.value(scaleOption).toDouble(&ok);
+    int repeat = parser.value(repeatOption).toInt();
+    FileWriteBackend::Kind backend = FileWriteBackend::Portable;
+    qint64 memoryBudget = 0;
+    if (!ok || scale <= 0 || repeat <= 0 || !FileWriteBackend::parseKind(parser.value(backendOption), backend)
+        || !MemoryBudget::parseSize(parser.value(maxMemoryOption), memoryBudget)) {
+        QTextStream(stderr) << "invalid --scale, --repeat, --write-backend or --max-memory" << Qt::endl;
+        return 2;
+    }
+
+    // 没有指定工作目录时生成到临时目录，结束后删除
+    QTemporaryDir tempDir;
+    QString workDir = parser.value(workDirOption);
+    if (workDir.isEmpty()) {
+        if (!tempDir.isValid()) {
+            QTextStream(stderr) << "cannot create a temporary directory" << Qt::endl;
+            return 1;
+        }
+        workDir = tempDir.path();
+    }
+    // 不同规模的安装包分开存放，复用时不会混用
+    QString payloadDir = QDir(workDir).filePath(QStringLiteral("scale-%1").arg(scale));
+    if (!QDir().mkpath(payloadDir)) {
+        QTextStream(stderr) << "cannot create " << payloadDir << Qt::endl;
+        return 1;
+    }
+
+    Bench bench(repeat, parser.value(threadsOption).toInt(), backend, memoryBudget, workDir);
+    bool failed = false;
+    for (const QString &scenario : std::as_const(scenarios)) {
+        for (const QString &format : std::as_const(formats)) {
+            Payload payload;
+            payload.scenario = scenario;
+            payload.format = format;
+            if (!generatePayload(parser.value(pythonOption), payloadDir, scale, payload)
+                    || !bench.preparePayload(payload)) {
+                QTextStream(stderr) << "cannot prepare " << scenario << '/' << format << Qt::endl;
+                failed = true;
+                continue;
+            }
+            bench.runAll(payload);
+        }
+    }
+
+    QJsonObject report;
+    report[QStringLiteral("scale")] = scale;
+    report[QStringLiteral("repeat")] = repeat;
+    report[QStringLiteral("threads")] = parser.value(threadsOption).toInt();
+    report[QStringLiteral("writeBackend")] = FileWriteBackend::kindName(backend);
+    report[QStringLiteral("maxMemory")] = memoryBudget;
+    report[QStringLiteral("results")] = bench.results();
+    QTextStream(stdout) << QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    for (const QJsonValue &value : bench.results()) {
+        failed = failed || !value.toObject().value(QStringLiteral("ok")).toBool();
+    }
+    return failed ? 1 : 0;
+}
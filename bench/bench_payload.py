@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+基准测试用的合成安装包：生成一组文件，打成 ZIP，再像构建时一样用 append_zip.py 附加到一个假的可执行文件上。
+每个场景生成两个文件：带 AUSIC 末尾元数据的 <name>.bin，以及只拼接了 ZIP、需要扫描定位的 <name>.notrailer.bin
+（只有 zip 格式有，分帧格式离不开清单）
+"""
+
+import os
+import sys
+import argparse
+import contextlib
+import io
+import random
+import tempfile
+import zipfile
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from append_zip import append_zip_to_exe
+
+# 假可执行文件的大小，定位时需要跳过的部分
+STUB_SIZE = 1024 * 1024
+
+WORDS = [b'ausic', b'audio', b'player', b'stream', b'buffer', b'module', b'class', b'return',
+         b'static', b'import', b'value', b'index', b'frame', b'track', b'volume', b'sample']
+
+
+def compressible_bytes(rng, size):
+    """Text-like data that deflates roughly 3-4x, similar to class files and resources."""
+    out = bytearray()
+    while len(out) < size:
+        out += rng.choice(WORDS) + b' '
+        if rng.random() < 0.1:
+            out += b'%d\n' % rng.randrange(1 << 20)
+    return bytes(out[:size])
+
+
+def tiny_files(rng, scale):
+    """Many small files, the shape of a JRE or node_modules tree."""
+    for i in range(int(20000 * scale)):
+        yield 'lib/pkg%03d/file%05d.txt' % (i % 200, i), compressible_bytes(rng, rng.randrange(0, 4096))
+
+
+def huge_files(rng, scale):
+    """A few very large files, like the JRE modules image."""
+    block = compressible_bytes(rng, 1024 * 1024)
+    for i in range(3):
+        size = int(128 * scale) * len(block)
+        data = bytearray(block * int(128 * scale))
+        # 每 MiB 打一个标记，避免整个文件只是同一块数据的重复
+        for offset in range(0, size, len(block)):
+            data[offset:offset + 8] = offset.to_bytes(8, 'little')
+        yield 'data/huge%d.bin' % i, bytes(data)
+
+
+def incompressible_files(rng, scale):
+    """Random data: deflate falls back to stored blocks and LZ4 to stored frames."""
+    for i in range(int(8 * scale) or 1):
+        yield 'media/random%02d.bin' % i, os.urandom(16 * 1024 * 1024)
+
+
+def deep_files(rng, scale):
+    """A deep, narrow directory tree: parent creation dominates."""
+    for i in range(int(2000 * scale)):
+        depth = 8 + i % 57
+        path = '/'.join('d%02d' % ((i + level) % 7) for level in range(depth))
+        yield '%s/leaf%05d.txt' % (path, i), compressible_bytes(rng, 256)
+
+
+SCENARIOS = {
+    'tiny': tiny_files,
+    'huge': huge_files,
+    'incompressible': incompressible_files,
+    'deep': deep_files,
+}
+
+
+def build_zip(zip_path, files):
+    count = 0
+    size = 0
+    with zipfile.ZipFile(zip_path, 'w', zipfile.ZIP_DEFLATED, compresslevel=6) as zf:
+        for name, data in files:
+            zf.writestr(name, data)
+            count += 1
+            size += len(data)
+    return count, size
+
+
+def write_stub(path):
+    with open(path, 'wb') as f:
+        f.write(b'\x7fELF' + bytes(STUB_SIZE - 4))
+
+
+def generate(scenario, payload_format, output_dir, scale, seed):
+    rng = random.Random(seed)
+    os.makedirs(output_dir, exist_ok=True)
+    with tempfile.TemporaryDirectory() as temp_dir:
+        zip_path = os.path.join(temp_dir, scenario + '.zip')
+        count, size = build_zip(zip_path, SCENARIOS[scenario](rng, scale))
+
+        exe_path = os.path.join(output_dir, '%s-%s.bin' % (scenario, payload_format))
+        write_stub(exe_path)
+        # append_zip 的进度输出对基准测试没有意义
+        with contextlib.redirect_stdout(io.StringIO()):
+            if not append_zip_to_exe(exe_path, zip_path, False, payload_format):
+                raise RuntimeError("failed to append payload for " + scenario)
+
+        if payload_format == 'zip':
+            plain_path = os.path.join(output_dir, '%s-%s.notrailer.bin' % (scenario, payload_format))
+            write_stub(plain_path)
+            with open(plain_path, 'ab') as out, open(zip_path, 'rb') as zf:
+                out.write(zf.read())
+
+    print('%s %s %d %d' % (scenario, exe_path, count, size))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Generate synthetic installer payloads for ausic_bench")
+    parser.add_argument("--scenario", choices=sorted(SCENARIOS), required=True)
+    parser.add_argument("--format", choices=("zip", "lz4"), default="zip")
+    parser.add_argument("--output", required=True, help="directory for the generated files")
+    parser.add_argument("--scale", type=float, default=1.0, help="multiplies file counts and sizes")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    generate(args.scenario, args.format, args.output, args.scale, args.seed)
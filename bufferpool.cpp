@@ -0,0 +1,82 @@
+#include "bufferpool.h"
+
+BufferPool::Slab::Slab()
+    : m_stats{ 0, 0, 0 }
+{
+}
+
+char *BufferPool::Slab::buffer(int index, int size)
+{
+    if (index >= m_buffers.size()) {
+        m_buffers.resize(index + 1);
+        m_bufferPaths.resize(index + 1);
+    }
+    QByteArray &buffer = m_buffers[index];
+    if (buffer.size() < size) {
+        buffer.resize(size);
+        m_stats.allocations++;
+        m_stats.allocatedBytes += size;
+    } else {
+        m_stats.reuses++;
+    }
+    return buffer.data();
+}
+
+QString &BufferPool::Slab::bufferPath(int index)
+{
+    return m_bufferPaths[index];
+}
+
+const QString &BufferPool::Slab::outputPath(QStringView prefix, QStringView relative)
+{
+    assign(m_scratch, prefix, relative);
+    return m_scratch;
+}
+
+void BufferPool::Slab::assign(QString &target, QStringView first, QStringView second)
+{
+    // 截断不释放容量；容量不够时一次留足，之后的路径大多不会再扩容
+    qsizetype length = first.size() + second.size();
+    target.truncate(0);
+    if (target.capacity() < length) {
+        target.reserve(qMax<qsizetype>(length, MIN_PATH_CAPACITY));
+        m_stats.allocations++;
+        m_stats.allocatedBytes += target.capacity() * qsizetype(sizeof(QChar));
+    } else {
+        m_stats.reuses++;
+    }
+    target.append(first);
+    target.append(second);
+}
+
+BufferPool::BufferPool()
+{
+}
+
+BufferPool::~BufferPool()
+{
+    qDeleteAll(m_slabs);
+}
+
+void BufferPool::reserve(int count)
+{
+    while (m_slabs.size() < count) {
+        m_slabs.append(new Slab);
+    }
+}
+
+BufferPool::Slab &BufferPool::slab(int index)
+{
+    return *m_slabs.at(index);
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+    Stats total = { 0, 0, 0 };
+    for (const Slab *slab : m_slabs) {
+        total.allocations += slab->m_stats.allocations;
+        total.allocatedBytes += slab->m_stats.allocatedBytes;
+        total.reuses += slab->m_stats.reuses;
+    }
+    return total;
+}
@@ -0,0 +1,68 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+// 解压缓冲池，由 ExtractionEngine 持有，每个工作线程一块 slab：解压/写盘缓冲环的缓冲块、
+// 每个缓冲块所属文件的输出路径，以及拼接输出路径的暂存区。
+// slab 在条目之间、多次 extract() 之间复用，只在第一次使用或需要更大的缓冲块、更长的路径时分配，
+// 稳定状态下每个条目不做堆分配；分配和复用次数分别计数，用来确认这一点
+class BufferPool
+{
+public:
+    struct Stats {
+        qint64 allocations;     // 分配或扩容的次数
+        qint64 allocatedBytes;
+        qint64 reuses;          // 直接复用、没有分配的次数
+    };
+
+    // 只由一个工作线程使用，计数不需要原子操作
+    class Slab
+    {
+    public:
+        Slab();
+
+        // 第 index 个缓冲块，至少 size 字节
+        char *buffer(int index, int size);
+
+        // 第 index 个缓冲块附带的路径
+        QString &bufferPath(int index);
+
+        // prefix + relative 拼接到暂存区，返回的引用在下次调用之前有效
+        const QString &outputPath(QStringView prefix, QStringView relative);
+
+        // 把 first + second 写入 target，容量足够时不分配
+        void assign(QString &target, QStringView first, QStringView second = QStringView());
+
+    private:
+        friend class BufferPool;
+
+        QVector<QByteArray> m_buffers;
+        QVector<QString> m_bufferPaths;
+        QString m_scratch;
+        Stats m_stats;
+    };
+
+    BufferPool();
+    ~BufferPool();
+
+    // 在启动工作线程之前调用，保证有 count 块 slab；已有的 slab 保留
+    void reserve(int count);
+    Slab &slab(int index);
+
+    // 所有 slab 的累计值，在工作线程都结束之后调用
+    Stats stats() const;
+
+    // 路径暂存区第一次分配的最小容量，避免逐次增长
+    static const int MIN_PATH_CAPACITY = 256;
+
+private:
+    Q_DISABLE_COPY(BufferPool)
+
+    QVector<Slab *> m_slabs;    // 指针保存，reserve 扩容时各线程持有的引用不会失效
+};
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,209 @@
+#include "crc32.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC32_PCLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC32_TARGET_PCLMUL
+#else
+#include <cpuid.h>
+#define CRC32_TARGET_PCLMUL __attribute__((target("sse2,pclmul")))
+#endif
+#endif
+
+namespace {
+
+const quint32 POLYNOMIAL = 0xedb88320u;
+
+// 一次处理 8 字节的查表法（slicing-by-8），没有 PCLMULQDQ 时使用
+struct Crc32Table
+{
+    quint32 entries[8][256];
+
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+            }
+            entries[0][i] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int i = 0; i < 256; i++) {
+                quint32 crc = entries[k - 1][i];
+                entries[k][i] = entries[0][crc & 0xff] ^ (crc >> 8);
+            }
+        }
+    }
+};
+
+const Crc32Table TABLE;
+
+// crc 为取反后的内部状态
+quint32 updateScalar(quint32 crc, const uchar *data, qint64 size)
+{
+    while (size >= 8) {
+        quint32 low = (quint32(data[0]) | quint32(data[1]) << 8 | quint32(data[2]) << 16
+                       | quint32(data[3]) << 24) ^ crc;
+        quint32 high = quint32(data[4]) | quint32(data[5]) << 8 | quint32(data[6]) << 16
+                       | quint32(data[7]) << 24;
+        crc = TABLE.entries[7][low & 0xff] ^ TABLE.entries[6][(low >> 8) & 0xff]
+              ^ TABLE.entries[5][(low >> 16) & 0xff] ^ TABLE.entries[4][low >> 24]
+              ^ TABLE.entries[3][high & 0xff] ^ TABLE.entries[2][(high >> 8) & 0xff]
+              ^ TABLE.entries[1][(high >> 16) & 0xff] ^ TABLE.entries[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = TABLE.entries[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef CRC32_PCLMUL
+
+// 无进位乘法折叠（Intel《Fast CRC Computation Using PCLMULQDQ》），
+// 每次折叠 64 字节，最后用 Barrett 约简得到 32 位结果。size 至少 64 且是 16 的倍数
+alignas(16) const quint64 K1K2[2] = { 0x0154442bd4ull, 0x01c6e41596ull };
+alignas(16) const quint64 K3K4[2] = { 0x01751997d0ull, 0x00ccaa009eull };
+alignas(16) const quint64 K5K0[2] = { 0x0163cd6124ull, 0x0000000000ull };
+alignas(16) const quint64 POLY_MU[2] = { 0x01db710641ull, 0x01f7011641ull };
+
+CRC32_TARGET_PCLMUL
+quint32 updateFolding(quint32 crc, const uchar *data, qint64 size)
+{
+    const __m128i *in = reinterpret_cast<const __m128i *>(data);
+    __m128i x1 = _mm_xor_si128(_mm_loadu_si128(in), _mm_cvtsi32_si128(int(crc)));
+    __m128i x2 = _mm_loadu_si128(in + 1);
+    __m128i x3 = _mm_loadu_si128(in + 2);
+    __m128i x4 = _mm_loadu_si128(in + 3);
+    in += 4;
+    size -= 64;
+
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i *>(K1K2));
+    while (size >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), x5), _mm_loadu_si128(in));
+        x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k, 0x11), x6), _mm_loadu_si128(in + 1));
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k, 0x11), x7), _mm_loadu_si128(in + 2));
+        x4 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x4, k, 0x11), x8), _mm_loadu_si128(in + 3));
+        in += 4;
+        size -= 64;
+    }
+
+    // 四路合并为一路，再逐个折叠剩余的 16 字节块
+    k = _mm_load_si128(reinterpret_cast<const __m128i *>(K3K4));
+    const __m128i rest[3] = { x2, x3, x4 };
+    for (const __m128i &next : rest) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), next), low);
+    }
+    while (size >= 16) {
+        __m128i low = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), _mm_loadu_si128(in)), low);
+        in++;
+        size -= 16;
+    }
+
+    // 128 位折叠到 64 位
+    const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(K5K0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00), x2);
+
+    // Barrett 约简到 32 位
+    k = _mm_load_si128(reinterpret_cast<const __m128i *>(POLY_MU));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return quint32(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+}
+
+bool detectPclmul()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL);
+#endif
+}
+
+const bool HAS_PCLMUL = detectPclmul();
+
+#endif // CRC32_PCLMUL
+
+// GF(2) 上模多项式的乘法与 x^(2^k) 表，用于合并分段 CRC（同 zlib 的 crc32_combine）
+quint32 multiplyModP(quint32 a, quint32 b)
+{
+    quint32 m = 1u << 31;
+    quint32 p = 0;
+    forever {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+    }
+    return p;
+}
+
+struct PowerTable
+{
+    quint32 entries[32];
+
+    PowerTable()
+    {
+        quint32 p = 1u << 30;   // x^1
+        entries[0] = p;
+        for (int n = 1; n < 32; n++) {
+            entries[n] = p = multiplyModP(p, p);
+        }
+    }
+};
+
+const PowerTable POWERS;
+
+} // namespace
+
+quint32 Crc32::update(quint32 crc, const uchar *data, qint64 size)
+{
+    crc = ~crc;
+
+#ifdef CRC32_PCLMUL
+    if (HAS_PCLMUL && size >= 64) {
+        qint64 folded = size & ~qint64(15);
+        crc = updateFolding(crc, data, folded);
+        data += folded;
+        size -= folded;
+    }
+#endif
+
+    return ~updateScalar(crc, data, size);
+}
+
+quint32 Crc32::combine(quint32 crc1, quint32 crc2, qint64 size2)
+{
+    // crc1 乘以 x^(8 * size2)，相当于在第一段之后补上 size2 个零字节
+    quint32 power = 1u << 31;
+    int k = 3;
+    for (quint64 n = quint64(size2); n; n >>= 1, k++) {
+        if (n & 1) {
+            power = multiplyModP(POWERS.entries[k & 31], power);
+        }
+    }
+    return multiplyModP(power, crc1) ^ crc2;
+}
@@ -0,0 +1,18 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <QtGlobal>
+
+// ZIP 使用的 CRC-32（多项式 0xEDB88320），可以分段累加
+// 支持 PCLMULQDQ 的 CPU 上用无进位乘法折叠，否则按 8 字节查表
+class Crc32
+{
+public:
+    // crc 为之前各段的结果，第一段传 0
+    static quint32 update(quint32 crc, const uchar *data, qint64 size);
+
+    // 由两段数据各自的 CRC 得到连起来的 CRC，size2 为第二段的长度
+    static quint32 combine(quint32 crc1, quint32 crc2, qint64 size2);
+};
+
+#endif // CRC32_H
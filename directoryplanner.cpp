@@ -0,0 +1,181 @@
+#include "directoryplanner.h"
+#include "filewritebackend.h"
+#include "zipindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QThread>
+
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+int depthOf(const QString &path)
+{
+    return path.count(QLatin1Char('/')) + 1;
+}
+
+QString prefixOf(const QString &path, int depth)
+{
+    return path.section(QLatin1Char('/'), 0, depth - 1);
+}
+
+} // namespace
+
+DirectoryPlanner::DirectoryPlanner(const QString &targetDir)
+    : m_targetDir(QDir(targetDir).absolutePath())
+    , m_entryCount(0)
+    , m_systemCalls(0)
+    , m_failedCalls(0)
+{
+}
+
+void DirectoryPlanner::collect(const QVector<ZipEntry> &entries)
+{
+    QSet<QString> directories;
+    m_entryCount = 0;
+    for (const ZipEntry &entry : entries) {
+        if (entry.filePath.isEmpty()) {
+            continue;
+        }
+        m_entryCount++;
+
+        // 目录条目本身和每个条目的所有上级目录；已经见过的上级目录不再向上追溯
+        QString path = entry.isDir ? entry.filePath : entry.filePath.section(QLatin1Char('/'), 0, -2);
+        while (!path.isEmpty() && !directories.contains(path)) {
+            directories.insert(path);
+            path = path.section(QLatin1Char('/'), 0, -2);
+        }
+    }
+
+    m_directories = QStringList(directories.cbegin(), directories.cend());
+    m_directories.sort();
+}
+
+bool DirectoryPlanner::create(int threadCount)
+{
+    m_systemCalls.storeRelaxed(0);
+    m_failedCalls.storeRelaxed(0);
+    if (!QDir().mkpath(m_targetDir)) {
+        m_failedCalls.storeRelaxed(1);
+        return false;
+    }
+
+    int workerCount = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    if (workerCount <= 1 || m_directories.size() < MIN_PARALLEL_DIRECTORIES) {
+        return createAll(m_directories);
+    }
+
+    // 找到足够分给各线程的拆分深度：更浅的目录先在当前线程创建，
+    // 之后以该深度的每个目录为根的子树互不依赖，可以并行创建
+    int splitDepth = 1;
+    forever {
+        QSet<QString> roots;
+        bool deeper = false;
+        for (const QString &path : std::as_const(m_directories)) {
+            int depth = depthOf(path);
+            if (depth >= splitDepth) {
+                roots.insert(prefixOf(path, splitDepth));
+            }
+            deeper = deeper || depth > splitDepth;
+        }
+        if (roots.size() >= workerCount || !deeper) {
+            break;
+        }
+        splitDepth++;
+    }
+
+    QStringList shallow;
+    QMap<QString, QStringList> subtrees;
+    for (const QString &path : std::as_const(m_directories)) {
+        if (depthOf(path) < splitDepth) {
+            shallow.append(path);
+        } else {
+            subtrees[prefixOf(path, splitDepth)].append(path);
+        }
+    }
+    if (!createAll(shallow)) {
+        return false;
+    }
+
+    const QVector<QStringList> groups(subtrees.cbegin(), subtrees.cend());
+    QAtomicInteger<int> nextGroup(0);
+    QAtomicInteger<int> failed(0);
+    QVector<QThread *> workers;
+    for (int i = 0; i < qMin(workerCount, int(groups.size())); i++) {
+        QThread *thread = QThread::create([this, &groups, &nextGroup, &failed]() {
+            forever {
+                int group = nextGroup.fetchAndAddRelaxed(1);
+                if (group >= groups.size() || failed.loadRelaxed() != 0) {
+                    break;
+                }
+                if (!createAll(groups.at(group))) {
+                    failed.storeRelaxed(1);
+                }
+            }
+        });
+        workers.append(thread);
+        thread->start();
+    }
+    for (QThread *thread : std::as_const(workers)) {
+        thread->wait();
+        delete thread;
+    }
+
+    return failed.loadRelaxed() == 0;
+}
+
+const QStringList &DirectoryPlanner::directories() const
+{
+    return m_directories;
+}
+
+DirectoryPlanner::Stats DirectoryPlanner::stats() const
+{
+    Stats stats;
+    stats.directories = m_directories.size();
+    stats.systemCalls = m_systemCalls.loadRelaxed();
+    stats.mkpathCallsAvoided = m_entryCount;
+    stats.failedCalls = m_failedCalls.loadRelaxed();
+    return stats;
+}
+
+bool DirectoryPlanner::createAll(const QStringList &directories)
+{
+    // 列表有序，创建每个目录时它的上级目录已经存在，只需一次 mkdir
+    for (const QString &path : directories) {
+        if (!makeDirectory(path)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DirectoryPlanner::makeDirectory(const QString &relativePath)
+{
+    QString path = m_targetDir + QLatin1Char('/') + relativePath;
+    m_systemCalls.fetchAndAddRelaxed(1);
+
+    // 已经存在（升级安装）也算成功；同名文件由 UpgradePlanner 事先删除
+#if defined(Q_OS_WIN)
+    QString nativePath;
+    FileWriteBackend::toNativePath(path, nativePath);
+    bool created = CreateDirectoryW(reinterpret_cast<const wchar_t *>(nativePath.utf16()), nullptr)
+                   || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    bool created = ::mkdir(QFile::encodeName(path).constData(), 0777) == 0 || errno == EEXIST;
+#endif
+    if (!created) {
+        m_failedCalls.fetchAndAddRelaxed(1);
+    }
+    return created;
+}
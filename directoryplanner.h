@@ -0,0 +1,49 @@
+#ifndef DIRECTORYPLANNER_H
+#define DIRECTORYPLANNER_H
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct ZipEntry;
+
+// 解压前一次性创建安装包中的全部目录：从条目列表收集不重复的目录，
+// 按父目录在前的顺序逐级 mkdir，各子树分给多个线程并行创建，
+// 之后每个文件写入前不再需要 QDir().mkpath()
+class DirectoryPlanner
+{
+public:
+    struct Stats {
+        int directories;            // 不重复的目录数
+        int systemCalls;            // 实际发出的 mkdir 调用数
+        int mkpathCallsAvoided;     // 原来每个条目一次的 mkpath（每次都要逐级检查路径）
+        int failedCalls;            // 失败的 mkdir 调用数（已存在不算失败）
+    };
+
+    explicit DirectoryPlanner(const QString &targetDir);
+
+    // 条目路径应已通过 ZipIndex::isSafePath() 检查
+    void collect(const QVector<ZipEntry> &entries);
+
+    // 0 表示使用 QThread::idealThreadCount()
+    bool create(int threadCount);
+
+    const QStringList &directories() const;
+    Stats stats() const;
+
+    // 目录少于这个数时在当前线程创建，不值得启动线程
+    static const int MIN_PARALLEL_DIRECTORIES = 256;
+
+private:
+    bool createAll(const QStringList &directories);
+    bool makeDirectory(const QString &relativePath);
+
+    QString m_targetDir;
+    QStringList m_directories;      // 按字典序排序，父目录一定在子目录之前
+    int m_entryCount;
+    QAtomicInteger<int> m_systemCalls;
+    QAtomicInteger<int> m_failedCalls;
+};
+
+#endif // DIRECTORYPLANNER_H
@@ -0,0 +1,495 @@
+#include "entrystreamer.h"
+#include "zipindex.h"
+#include "progresstracker.h"
+#include "installjournal.h"
+#include "installmetrics.h"
+#include "tracerecorder.h"
+#include "lz4block.h"
+#include "memorybudget.h"
+#include "crc32.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <cstring>
+#include <utility>
+
+EntryStreamer::EntryStreamer(BufferPool::Slab &slab, int bufferCount, int bufferSize)
+    : m_slab(slab)
+    , m_bufferSize(bufferSize)
+    , m_head(0)
+    , m_tail(0)
+    , m_filled(0)
+    , m_stopping(false)
+    , m_failed(false)
+    , m_writerThread(nullptr)
+    , m_frames(nullptr)
+    , m_progress(nullptr)
+    , m_metrics(nullptr)
+    , m_journal(nullptr)
+    , m_inflateNsecs(0)
+    , m_releaseInput(false)
+    , m_backendKind(FileWriteBackend::Portable)
+    , m_backend(nullptr)
+    , m_written(0)
+    , m_pendingBytes(0)
+    , m_pendingFiles(0)
+    , m_writeNsecs(0)
+    , m_flushNsecs(0)
+    , m_failedCalls(0)
+{
+    // 缓冲块取自 slab，之后在条目之间循环复用；先取齐缓冲块，slab 扩充时路径的位置可能变化
+    m_chunks.resize(qMax(2, bufferCount));
+    for (int i = 0; i < m_chunks.size(); i++) {
+        m_chunks[i].buffer = m_slab.buffer(i, bufferSize);
+    }
+    for (int i = 0; i < m_chunks.size(); i++) {
+        Chunk &chunk = m_chunks[i];
+        chunk.path = &m_slab.bufferPath(i);
+        chunk.length = 0;
+        chunk.beginFile = false;
+        chunk.endFile = false;
+        chunk.expectedSize = 0;
+        chunk.fileOffset = -1;
+        chunk.countsFile = false;
+        chunk.entry = nullptr;
+    }
+    // 等待确认的文件不会多于缓冲块数
+    m_pendingEntries.reserve(m_chunks.size());
+}
+
+EntryStreamer::~EntryStreamer()
+{
+    finish();
+}
+
+void EntryStreamer::setProgressTracker(ProgressTracker *tracker)
+{
+    m_progress = tracker;
+}
+
+void EntryStreamer::setMetrics(InstallMetrics *metrics)
+{
+    m_metrics = metrics;
+}
+
+void EntryStreamer::setJournal(InstallJournal *journal)
+{
+    m_journal = journal;
+}
+
+void EntryStreamer::setFrameTable(const FrameTable *frames)
+{
+    m_frames = frames;
+}
+
+void EntryStreamer::setInputRelease(bool enabled)
+{
+    m_releaseInput = enabled;
+}
+
+void EntryStreamer::setWriteBackend(FileWriteBackend::Kind kind)
+{
+    m_backendKind = kind;
+}
+
+void EntryStreamer::start()
+{
+    if (m_writerThread) {
+        return;
+    }
+
+    // 至少留一半缓冲块给解压线程，让解压和写盘可以同时进行
+    m_backend = FileWriteBackend::create(m_backendKind, qMax(1, int(m_chunks.size()) / 2));
+    m_stopping = false;
+    m_writerThread = QThread::create([this]() {
+        TraceRecorder::setThreadName("writer");
+        writerLoop();
+    });
+    m_writerThread->start();
+}
+
+bool EntryStreamer::extractEntry(const uchar *data, const ZipEntry &entry, const QString &outputPath)
+{
+    if (entry.method == ZipIndex::METHOD_LZ4_FRAMES) {
+        return m_frames && extractFrames(data, entry, entry.firstFrame,
+                                         m_frames->frameCount(entry.uncompressedSize), outputPath, -1, nullptr);
+    }
+
+    bool stored = entry.method == ZipIndex::METHOD_STORED;
+    if (!stored && entry.method != ZipIndex::METHOD_DEFLATED) {
+        return false;
+    }
+    if (stored && entry.compressedSize != entry.uncompressedSize) {
+        return false;
+    }
+
+    if (!stored) {
+        m_inflater.reset(data, entry.compressedSize);
+    }
+
+    qint64 produced = 0;
+    qint64 consumed = 0;
+    qint64 released = 0;
+    quint32 crc = 0;
+    bool first = true;
+    bool last = false;
+
+    while (!last) {
+        Chunk *chunk = acquireChunk();
+        if (!chunk) {
+            return false;
+        }
+
+        TraceRecorder::Scope scope("inflate", outputPath);
+        QElapsedTimer inflateTimer;
+        inflateTimer.start();
+        uchar *out = reinterpret_cast<uchar *>(chunk->buffer);
+        qint64 length = 0;
+        if (stored) {
+            length = qMin<qint64>(m_bufferSize, entry.uncompressedSize - produced);
+            memcpy(out, data + produced, size_t(length));
+            produced += length;
+            consumed = produced;
+            last = produced == entry.uncompressedSize;
+            if (m_progress) {
+                m_progress->addCompressedRead(length);
+            }
+        } else {
+            length = m_inflater.read(out, m_bufferSize);
+            if (length < 0) {
+                setFailed();
+                return false;
+            }
+            produced += length;
+            last = m_inflater.atEnd();
+            qint64 totalIn = m_inflater.totalIn();
+            if (m_progress) {
+                m_progress->addCompressedRead(totalIn - consumed);
+            }
+            consumed = totalIn;
+        }
+        releaseInput(data, consumed, released, last);
+
+        // 解压结果超过中央目录记录的大小，或 CRC 不一致，说明数据损坏；
+        // 最后一块不再交给写入线程，写了一半的文件由写入线程删除
+        crc = Crc32::update(crc, out, length);
+        m_inflateNsecs += inflateTimer.nsecsElapsed();
+        if (produced > entry.uncompressedSize || (last && crc != entry.crc32)) {
+            setFailed();
+            return false;
+        }
+
+        chunk->length = length;
+        chunk->beginFile = first;
+        chunk->endFile = last;
+        chunk->expectedSize = entry.uncompressedSize;
+        chunk->fileOffset = -1;
+        chunk->countsFile = true;
+        chunk->entry = &entry;
+        if (first) {
+            m_slab.assign(*chunk->path, outputPath);
+        }
+        publishChunk();
+        first = false;
+    }
+
+    return true;
+}
+
+bool EntryStreamer::extractFrames(const uchar *data, const ZipEntry &entry, int firstFrame, int frameCount,
+                                  const QString &outputPath, qint64 fileOffset, quint32 *segmentCrc)
+{
+    if (!m_frames || m_frames->frameSize > m_bufferSize || entry.method != ZipIndex::METHOD_LZ4_FRAMES) {
+        return false;
+    }
+
+    // 每一帧正好解压到一个缓冲块里，除最后一帧外都是 frameSize 字节
+    qint64 start = qint64(firstFrame - entry.firstFrame) * m_frames->frameSize;
+    qint64 expectedSize = qMin(entry.uncompressedSize, start + qint64(frameCount) * m_frames->frameSize) - start;
+    const uchar *in = data;
+    qint64 released = 0;
+    qint64 produced = 0;
+    quint32 crc = 0;
+    int frame = firstFrame;
+    bool first = true;
+    bool last = false;
+
+    // 空文件没有帧，但仍然需要一个块来创建文件
+    while (!last) {
+        Chunk *chunk = acquireChunk();
+        if (!chunk) {
+            return false;
+        }
+
+        TraceRecorder::Scope scope("inflate", outputPath);
+        QElapsedTimer inflateTimer;
+        inflateTimer.start();
+        uchar *out = reinterpret_cast<uchar *>(chunk->buffer);
+        qint64 length = 0;
+        if (frame < firstFrame + frameCount) {
+            qint64 frameLength = qMin<qint64>(m_frames->frameSize, expectedSize - produced);
+            qint64 compressed = m_frames->compressedSize(frame);
+            if (m_frames->isStored(frame)) {
+                length = compressed == frameLength ? frameLength : -1;
+                if (length > 0) {
+                    memcpy(out, in, size_t(length));
+                }
+            } else {
+                length = Lz4Block::decompress(in, compressed, out, frameLength);
+            }
+
+            // 帧解压后的大小必须和帧表一致，否则说明数据损坏
+            if (length != frameLength) {
+                setFailed();
+                return false;
+            }
+            crc = Crc32::update(crc, out, length);
+            in += compressed;
+            produced += length;
+            frame++;
+            if (m_progress) {
+                m_progress->addCompressedRead(compressed);
+            }
+        }
+        last = frame == firstFrame + frameCount;
+        releaseInput(data, in - data, released, last);
+        m_inflateNsecs += inflateTimer.nsecsElapsed();
+
+        // 整个文件在这里校验 CRC，分段的 CRC 交给调用方合并后校验
+        if (last && fileOffset < 0 && crc != entry.crc32) {
+            setFailed();
+            return false;
+        }
+
+        chunk->length = length;
+        chunk->beginFile = first;
+        chunk->endFile = last;
+        chunk->expectedSize = expectedSize;
+        chunk->fileOffset = fileOffset;
+        chunk->countsFile = fileOffset <= 0;
+        chunk->entry = fileOffset < 0 ? &entry : nullptr;
+        if (first) {
+            m_slab.assign(*chunk->path, outputPath);
+        }
+        publishChunk();
+        first = false;
+    }
+
+    if (segmentCrc) {
+        *segmentCrc = crc;
+    }
+    return true;
+}
+
+bool EntryStreamer::finish()
+{
+    if (m_writerThread) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_chunkFilled.wakeAll();
+        }
+        m_writerThread->wait();
+        delete m_writerThread;
+        m_writerThread = nullptr;
+        delete m_backend;
+        m_backend = nullptr;
+    }
+
+    if (m_metrics) {
+        m_metrics->addTime(InstallMetrics::Inflate, m_inflateNsecs);
+        m_metrics->addTime(InstallMetrics::Write, m_writeNsecs);
+        m_metrics->addTime(InstallMetrics::Flush, m_flushNsecs);
+        m_metrics->addFailedCalls(m_failedCalls);
+    }
+    m_inflateNsecs = 0;
+    m_writeNsecs = 0;
+    m_flushNsecs = 0;
+    m_failedCalls = 0;
+
+    QMutexLocker locker(&m_mutex);
+    return !m_failed;
+}
+
+EntryStreamer::Chunk *EntryStreamer::acquireChunk()
+{
+    QMutexLocker locker(&m_mutex);
+    // 缓冲块全部等待写盘时，时间线上记录解压线程被写盘拖住的时间
+    qint64 waitStart = -1;
+    while (m_filled == m_chunks.size() && !m_failed) {
+        if (waitStart < 0 && TraceRecorder::isEnabled()) {
+            waitStart = TraceRecorder::now();
+        }
+        m_chunkReleased.wait(&m_mutex);
+    }
+    if (waitStart >= 0) {
+        TraceRecorder::complete("wait-buffer", waitStart, TraceRecorder::now());
+    }
+    if (m_failed) {
+        return nullptr;
+    }
+    return &m_chunks[m_head];
+}
+
+void EntryStreamer::publishChunk()
+{
+    QMutexLocker locker(&m_mutex);
+    m_head = (m_head + 1) % m_chunks.size();
+    m_filled++;
+    m_chunkFilled.wakeOne();
+}
+
+void EntryStreamer::setFailed()
+{
+    QMutexLocker locker(&m_mutex);
+    m_failed = true;
+    m_chunkReleased.wakeAll();
+}
+
+void EntryStreamer::releaseInput(const uchar *data, qint64 consumed, qint64 &released, bool finished)
+{
+    if (m_releaseInput && consumed > released && (finished || consumed - released >= MemoryBudget::RELEASE_STEP)) {
+        MemoryBudget::releasePages(data + released, consumed - released);
+        released = consumed;
+    }
+}
+
+void EntryStreamer::writerLoop()
+{
+    // 从 m_tail 开始的 inFlight 个块已经交给后端，complete() 之前不能归还给解压线程
+    int inFlight = 0;
+    int maxPending = m_backend->maxPendingBuffers();
+
+    forever {
+        Chunk *chunk = nullptr;
+        bool failed = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (inFlight == 0) {
+                while (m_filled == 0 && !m_stopping) {
+                    m_chunkFilled.wait(&m_mutex);
+                }
+                if (m_filled == 0) {
+                    break;
+                }
+            }
+            if (m_filled > inFlight && inFlight < maxPending) {
+                chunk = &m_chunks[(m_tail + inFlight) % m_chunks.size()];
+            }
+            failed = m_failed;
+        }
+
+        if (chunk) {
+            if (failed) {
+                // 已经失败：丢弃剩余数据，删除写了一半的文件
+                m_backend->discard();
+            } else {
+                writeChunk(*chunk);
+            }
+            inFlight++;
+            continue;
+        }
+
+        // 后端已经持有足够多的块，或者暂时没有新数据：等待写完后一起归还；
+        // 批量提交的后端在这里才真正写盘，耗时计入 flush
+        QElapsedTimer flushTimer;
+        flushTimer.start();
+        bool completed;
+        {
+            TraceRecorder::Scope scope("flush");
+            completed = m_backend->complete();
+        }
+        m_flushNsecs += flushTimer.nsecsElapsed();
+        if (completed) {
+            if (m_progress) {
+                m_progress->addBytesWritten(m_pendingBytes);
+                m_progress->addFileDone(m_pendingFiles);
+            }
+            // 后端确认写完之后才记入日志，日志中的文件至少已经完整交给了系统
+            if (m_journal) {
+                for (const ZipEntry *entry : std::as_const(m_pendingEntries)) {
+                    m_journal->append(*entry);
+                }
+            }
+        } else {
+            m_failedCalls++;
+            setFailed();
+        }
+        m_pendingBytes = 0;
+        m_pendingFiles = 0;
+        m_pendingEntries.clear();
+
+        QMutexLocker locker(&m_mutex);
+        m_tail = (m_tail + inFlight) % m_chunks.size();
+        m_filled -= inFlight;
+        inFlight = 0;
+        m_chunkReleased.wakeAll();
+    }
+
+    // 解压线程中途失败时可能留下未结束的文件
+    m_backend->discard();
+}
+
+void EntryStreamer::writeChunk(Chunk &chunk)
+{
+    qint64 traceStart = TraceRecorder::isEnabled() ? TraceRecorder::now() : -1;
+    QElapsedTimer timer;
+    timer.start();
+    if (chunk.beginFile) {
+        // 只在记录时间线时保留路径，共享的字符串会让下次写入 chunk.path 时重新分配
+        if (TraceRecorder::isEnabled()) {
+            m_writingPath = *chunk.path;
+        }
+        // 分段写入的文件已经按最终大小创建好，每段从自己的位置开始写
+        if (!m_backend->begin(*chunk.path, chunk.fileOffset, chunk.expectedSize)) {
+            m_failedCalls++;
+            setFailed();
+            return;
+        }
+        m_written = 0;
+    }
+
+    if (chunk.length > 0) {
+        if (!m_backend->write(chunk.buffer, chunk.length)) {
+            m_failedCalls++;
+            m_backend->discard();
+            setFailed();
+            return;
+        }
+        m_written += chunk.length;
+        m_pendingBytes += chunk.length;
+    }
+    m_writeNsecs += timer.nsecsElapsed();
+    if (traceStart >= 0) {
+        TraceRecorder::complete("write", traceStart, TraceRecorder::now(), m_writingPath);
+    }
+
+    if (chunk.endFile) {
+        // 验证文件大小
+        if (m_written != chunk.expectedSize) {
+            m_backend->discard();
+            setFailed();
+            return;
+        }
+        timer.restart();
+        bool ended;
+        {
+            TraceRecorder::Scope scope("close", m_writingPath);
+            ended = m_backend->end();
+        }
+        m_flushNsecs += timer.nsecsElapsed();
+        if (!ended) {
+            m_failedCalls++;
+            setFailed();
+            return;
+        }
+        if (chunk.countsFile) {
+            m_pendingFiles++;
+        }
+        if (chunk.entry) {
+            m_pendingEntries.append(chunk.entry);
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef ENTRYSTREAMER_H
+#define ENTRYSTREAMER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "bufferpool.h"
+#include "filewritebackend.h"
+#include "inflater.h"
+
+class QThread;
+class InstallJournal;
+class InstallMetrics;
+class ProgressTracker;
+struct ZipEntry;
+struct FrameTable;
+
+// 流式解压条目：解压线程把数据填入固定数量的环形缓冲块，
+// 写入线程同时把已填满的块写到磁盘，峰值内存与条目大小无关。
+// 每块数据在解压线程中顺带计算 CRC，与条目记录不一致时该条目失败。
+// 写盘交给 FileWriteBackend，支持批量提交的后端可以一次持有多个已填满的块。
+// 缓冲块和输出路径来自工作线程的缓冲池 slab，条目之间不做堆分配
+class EntryStreamer
+{
+public:
+    explicit EntryStreamer(BufferPool::Slab &slab, int bufferCount = DEFAULT_BUFFER_COUNT,
+                           int bufferSize = DEFAULT_BUFFER_SIZE);
+    ~EntryStreamer();
+
+    void setProgressTracker(ProgressTracker *tracker);
+
+    // 解压、写入、刷新的耗时和失败的文件操作在本地累计，finish() 时一次性计入
+    void setMetrics(InstallMetrics *metrics);
+
+    // 整个写完并确认落盘的文件记入断点续装日志；分段写入的文件由调用方合并校验后记录
+    void setJournal(InstallJournal *journal);
+
+    // 分帧载荷的帧表，缓冲块不能小于帧大小
+    void setFrameTable(const FrameTable *frames);
+
+    // 为 true 时已经解压过的压缩数据每隔 MemoryBudget::RELEASE_STEP 字节移出工作集，
+    // 映射的安装包不会随解压进度一直占用内存
+    void setInputRelease(bool enabled);
+
+    // 写盘方式，在 start() 之前设置；不可用时退回 Portable
+    void setWriteBackend(FileWriteBackend::Kind kind);
+    void start();
+
+    // data 指向条目的压缩数据（映射内存）；函数返回时数据已全部交给写入线程
+    bool extractEntry(const uchar *data, const ZipEntry &entry, const QString &outputPath);
+
+    // 只解压分帧条目中从 firstFrame 开始的 frameCount 帧，data 指向其中第一帧。
+    // fileOffset 为 -1 时创建整个文件并校验 CRC，否则写入已预先创建好的文件中的对应位置，
+    // 这一段数据的 CRC 通过 segmentCrc 返回
+    bool extractFrames(const uchar *data, const ZipEntry &entry, int firstFrame, int frameCount,
+                       const QString &outputPath, qint64 fileOffset, quint32 *segmentCrc);
+
+    // 等待写入线程处理完所有缓冲块并退出，返回整个过程是否成功
+    bool finish();
+
+    static const int DEFAULT_BUFFER_COUNT = 4;
+    static const int DEFAULT_BUFFER_SIZE = 256 * 1024;
+
+    // 批量提交的后端使用的缓冲块数，其中一半可以同时交给后端
+    static const int BATCHED_BUFFER_COUNT = 16;
+
+private:
+    struct Chunk {
+        char *buffer;       // slab 中的缓冲块
+        qint64 length;
+        bool beginFile;
+        bool endFile;
+        QString *path;      // slab 中与缓冲块对应的路径，只在 beginFile 时有效
+        qint64 expectedSize;
+        qint64 fileOffset;  // -1 表示整个文件
+        bool countsFile;    // 分段写入的文件只在第一段计入完成文件数
+        const ZipEntry *entry;  // 整个文件写入时的条目，写完后记入日志；分段写入时为 nullptr
+    };
+
+    Chunk *acquireChunk();
+    void publishChunk();
+    void writerLoop();
+    void writeChunk(Chunk &chunk);
+    void setFailed();
+    void releaseInput(const uchar *data, qint64 consumed, qint64 &released, bool finished);
+
+    BufferPool::Slab &m_slab;
+    QVector<Chunk> m_chunks;
+    int m_bufferSize;
+    int m_head;
+    int m_tail;
+    int m_filled;
+    bool m_stopping;
+    bool m_failed;
+
+    QMutex m_mutex;
+    QWaitCondition m_chunkFilled;
+    QWaitCondition m_chunkReleased;
+    QThread *m_writerThread;
+
+    Inflater m_inflater;
+    const FrameTable *m_frames;
+    ProgressTracker *m_progress;
+    InstallMetrics *m_metrics;
+    InstallJournal *m_journal;
+    qint64 m_inflateNsecs;  // 仅由解压线程访问
+    bool m_releaseInput;
+
+    FileWriteBackend::Kind m_backendKind;
+
+    // 仅由写入线程访问
+    FileWriteBackend *m_backend;
+    qint64 m_written;
+    qint64 m_pendingBytes;  // 已交给后端、还没确认写完的字节数和文件数
+    int m_pendingFiles;
+    QVector<const ZipEntry *> m_pendingEntries;  // 已经结束、等待后端确认的整个文件
+    QString m_writingPath;  // 正在写入的文件，用于时间线
+    qint64 m_writeNsecs;
+    qint64 m_flushNsecs;
+    int m_failedCalls;
+};
+
+#endif // ENTRYSTREAMER_H
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include "extractionengine.h"
+#include "entrystreamer.h"
+#include "payloaddevice.h"
+#include "progresstracker.h"
+#include "crc32.h"
+#include "directoryplanner.h"
+#include "installjournal.h"
+#include "installmetrics.h"
+#include "tracerecorder.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <algorithm>
+#include <utility>
+
+ExtractionEngine::ExtractionEngine(PayloadDevice *payload)
+    : m_payload(payload)
+    , m_threadCount(0)
+    , m_progress(nullptr)
+    , m_metrics(nullptr)
+    , m_journal(nullptr)
+    , m_progressIntervalMs(16)
+    , m_deduplicate(true)
+    , m_cloneMode(FileCloner::Copy)
+    , m_writeBackend(FileWriteBackend::Portable)
+    , m_memoryBudget(0)
+    , m_entries(nullptr)
+    , m_frames(nullptr)
+    , m_aborted(0)
+{
+    m_directoryStats = { 0, 0, 0, 0 };
+    m_memoryPlan = { 0, 0, 0, 0 };
+}
+
+void ExtractionEngine::setThreadCount(int threadCount)
+{
+    m_threadCount = qMax(0, threadCount);
+}
+
+int ExtractionEngine::threadCount() const
+{
+    return m_threadCount > 0 ? m_threadCount : qMax(1, QThread::idealThreadCount());
+}
+
+void ExtractionEngine::setProgressTracker(ProgressTracker *tracker)
+{
+    m_progress = tracker;
+}
+
+void ExtractionEngine::setProgressCallback(const std::function<void()> &callback, int intervalMs)
+{
+    m_progressCallback = callback;
+    m_progressIntervalMs = qMax(1, intervalMs);
+}
+
+void ExtractionEngine::setMetrics(InstallMetrics *metrics)
+{
+    m_metrics = metrics;
+}
+
+void ExtractionEngine::setJournal(InstallJournal *journal)
+{
+    m_journal = journal;
+}
+
+void ExtractionEngine::setDeduplication(bool enabled, FileCloner::Mode mode)
+{
+    m_deduplicate = enabled;
+    m_cloneMode = mode;
+}
+
+int ExtractionEngine::duplicateCount() const
+{
+    return m_duplicates.size();
+}
+
+DirectoryPlanner::Stats ExtractionEngine::directoryStats() const
+{
+    return m_directoryStats;
+}
+
+void ExtractionEngine::setFrameTable(const FrameTable *frames)
+{
+    m_frames = frames && frames->frameSize > 0 ? frames : nullptr;
+}
+
+void ExtractionEngine::setWriteBackend(FileWriteBackend::Kind kind)
+{
+    m_writeBackend = kind;
+}
+
+void ExtractionEngine::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+}
+
+MemoryBudget::Plan ExtractionEngine::memoryPlan() const
+{
+    return m_memoryPlan;
+}
+
+BufferPool::Stats ExtractionEngine::bufferStats() const
+{
+    return m_pool.stats();
+}
+
+bool ExtractionEngine::extract(const QVector<ZipEntry> &entries, const QString &targetDir)
+{
+    m_targetDir = targetDir;
+    m_entries = &entries;
+    m_aborted.storeRelaxed(0);
+    m_duplicates.clear();
+    m_memoryPlan = { 0, 0, 0, 0 };
+
+    // 先在当前线程检查路径，收集需要解压的文件；
+    // 内容相同的文件只保留第一个，其余记为副本，解压完成后再复制
+    QVector<int> files;
+    files.reserve(entries.size());
+    QHash<QByteArray, int> firstByContent;
+    for (int i = 0; i < entries.size(); i++) {
+        const ZipEntry &entry = entries.at(i);
+        if (entry.isDir && entry.filePath.isEmpty()) {
+            continue;
+        }
+        if (!ZipIndex::isSafePath(entry.filePath)) {
+            return false;
+        }
+        if (entry.isDir) {
+            continue;
+        }
+
+        // 空文件直接解压，没有复制的必要；没有内容哈希的条目（旧格式安装包）只有 CRC，
+        // CRC 相同不能说明内容相同，也各自解压
+        if (m_deduplicate && entry.uncompressedSize > 0 && !entry.contentHash.isEmpty()) {
+            QByteArray key = contentKey(entry);
+            auto first = firstByContent.constFind(key);
+            if (first != firstByContent.constEnd()) {
+                m_duplicates.append(qMakePair(i, first.value()));
+                continue;
+            }
+            firstByContent.insert(key, i);
+        }
+        files.append(i);
+    }
+
+    // 一次性创建全部目录，之后解压、分段预建文件、复制副本时都不再检查上级目录
+    QElapsedTimer mkdirTimer;
+    mkdirTimer.start();
+    DirectoryPlanner directories(targetDir);
+    directories.collect(entries);
+    bool directoriesCreated = directories.create(threadCount());
+    m_directoryStats = directories.stats();
+    if (m_metrics) {
+        m_metrics->addTime(InstallMetrics::Mkdir, mkdirTimer.nsecsElapsed());
+        m_metrics->addFailedCalls(m_directoryStats.failedCalls);
+    }
+    if (!directoriesCreated) {
+        m_entries = nullptr;
+        return false;
+    }
+
+    if (files.isEmpty()) {
+        return true;
+    }
+
+    m_tasks.clear();
+    for (int index : std::as_const(files)) {
+        if (!appendTasks(index)) {
+            m_entries = nullptr;
+            return false;
+        }
+    }
+
+    // 大任务优先，避免最后只剩一个大文件在单线程上解压
+    QVector<int> order(m_tasks.size());
+    for (int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_tasks.at(a).size > m_tasks.at(b).size;
+    });
+
+    // 每个工作线程有自己的解压缓冲环和写入线程，分帧时每个缓冲块正好放下一帧；
+    // 批量提交的后端需要更多缓冲块才能攒够一批。有内存上限时按上限缩小缓冲、减少线程
+    int bufferSize = qMax<int>(EntryStreamer::DEFAULT_BUFFER_SIZE, m_frames ? m_frames->frameSize : 0);
+    int bufferCount = m_writeBackend == FileWriteBackend::Portable ? EntryStreamer::DEFAULT_BUFFER_COUNT
+                                                                   : EntryStreamer::BATCHED_BUFFER_COUNT;
+    m_memoryPlan = MemoryBudget::plan(m_memoryBudget, qMin(threadCount(), int(order.size())), bufferCount, bufferSize,
+                                      m_frames ? m_frames->frameSize : MemoryBudget::MIN_BUFFER_SIZE,
+                                      sizeof(EntryStreamer));
+    if (m_memoryPlan.workers == 0) {
+        m_entries = nullptr;
+        return false;
+    }
+    int workerCount = m_memoryPlan.workers;
+    m_pool.reserve(workerCount);
+    m_targetPrefix = QDir(targetDir).absolutePath();
+    if (!m_targetPrefix.endsWith(QLatin1Char('/'))) {
+        m_targetPrefix.append(QLatin1Char('/'));
+    }
+    for (int i = 0; i < workerCount; i++) {
+        WorkQueue *queue = new WorkQueue;
+        queue->head = 0;
+        m_queues.append(queue);
+    }
+    for (int i = 0; i < order.size(); i++) {
+        m_queues[i % workerCount]->tasks.append(order.at(i));
+    }
+
+    QVector<QThread *> workers;
+    for (int i = 0; i < workerCount; i++) {
+        QThread *thread = QThread::create([this, i]() { workerLoop(i); });
+        workers.append(thread);
+        thread->start();
+    }
+    // 等待期间按刷新间隔汇报进度，信号数量与文件数无关
+    for (QThread *thread : workers) {
+        while (!thread->wait(m_progressIntervalMs)) {
+            if (m_progressCallback) {
+                m_progressCallback();
+            }
+        }
+        delete thread;
+    }
+    if (m_progressCallback) {
+        m_progressCallback();
+    }
+
+    qDeleteAll(m_queues);
+    m_queues.clear();
+
+    bool ok = m_aborted.loadRelaxed() == 0 && verifySegments() && cloneDuplicates();
+    m_tasks.clear();
+    m_entries = nullptr;
+    return ok;
+}
+
+void ExtractionEngine::workerLoop(int worker)
+{
+    TraceRecorder::setThreadName(QString("extract-%1").arg(worker));
+    BufferPool::Slab &slab = m_pool.slab(worker);
+    EntryStreamer streamer(slab, m_memoryPlan.bufferCount, m_memoryPlan.bufferSize);
+    streamer.setProgressTracker(m_progress);
+    streamer.setMetrics(m_metrics);
+    streamer.setJournal(m_journal);
+    streamer.setFrameTable(m_frames);
+    streamer.setWriteBackend(m_writeBackend);
+    streamer.setInputRelease(m_memoryBudget > 0);
+    streamer.start();
+
+    while (m_aborted.loadRelaxed() == 0) {
+        int task = takeTask(worker);
+        if (task < 0) {
+            task = stealTask(worker);
+        }
+        if (task < 0) {
+            break;
+        }
+
+        if (!extractEntry(streamer, slab, m_tasks[task])) {
+            m_aborted.storeRelaxed(1);
+            break;
+        }
+    }
+
+    if (!streamer.finish()) {
+        m_aborted.storeRelaxed(1);
+    }
+}
+
+int ExtractionEngine::takeTask(int worker)
+{
+    // 自己的队列从头部取（大条目）
+    WorkQueue *queue = m_queues.at(worker);
+    QMutexLocker locker(&queue->mutex);
+    if (queue->head >= queue->tasks.size()) {
+        return -1;
+    }
+    return queue->tasks.at(queue->head++);
+}
+
+int ExtractionEngine::stealTask(int thief)
+{
+    // 从其他队列的尾部窃取（小条目），和队列主人的取用端错开
+    int queueCount = m_queues.size();
+    for (int offset = 1; offset < queueCount; offset++) {
+        WorkQueue *victim = m_queues.at((thief + offset) % queueCount);
+        QMutexLocker locker(&victim->mutex);
+        if (victim->head < victim->tasks.size()) {
+            return victim->tasks.takeLast();
+        }
+    }
+    return -1;
+}
+
+bool ExtractionEngine::verifySegments()
+{
+    // 同一文件的各段按顺序排在一起，把各段的 CRC 依次合并后与条目记录比较
+    quint32 crc = 0;
+    for (int i = 0; i < m_tasks.size(); i++) {
+        const Task &task = m_tasks.at(i);
+        if (task.firstFrame < 0) {
+            continue;
+        }
+        crc = task.fileOffset == 0 ? task.crc : Crc32::combine(crc, task.crc, task.size);
+
+        bool lastSegment = i + 1 == m_tasks.size() || m_tasks.at(i + 1).entry != task.entry;
+        const ZipEntry &entry = m_entries->at(task.entry);
+        if (lastSegment && crc != entry.crc32) {
+            QFile::remove(QDir(m_targetDir).absoluteFilePath(entry.filePath));
+            return false;
+        }
+        if (lastSegment && m_journal) {
+            m_journal->append(entry);
+        }
+    }
+    return true;
+}
+
+bool ExtractionEngine::cloneDuplicates()
+{
+    QDir targetDir(m_targetDir);
+    QElapsedTimer sinceReport;
+    sinceReport.start();
+
+    for (const QPair<int, int> &duplicate : std::as_const(m_duplicates)) {
+        const ZipEntry &entry = m_entries->at(duplicate.first);
+        QString source = targetDir.absoluteFilePath(m_entries->at(duplicate.second).filePath);
+        QString target = targetDir.absoluteFilePath(entry.filePath);
+
+        if (!FileCloner::clone(source, target, m_cloneMode)) {
+            if (m_metrics) {
+                m_metrics->addFailedCalls();
+            }
+            return false;
+        }
+        if (m_journal) {
+            m_journal->append(entry);
+        }
+
+        if (m_progress) {
+            m_progress->addCompressedRead(entry.compressedSize);
+            m_progress->addBytesWritten(entry.uncompressedSize);
+            m_progress->addFileDone();
+        }
+        if (m_progressCallback && sinceReport.elapsed() >= m_progressIntervalMs) {
+            m_progressCallback();
+            sinceReport.restart();
+        }
+    }
+
+    if (m_progressCallback && !m_duplicates.isEmpty()) {
+        m_progressCallback();
+    }
+    return true;
+}
+
+QByteArray ExtractionEngine::contentKey(const ZipEntry &entry)
+{
+    // 大小加内容哈希；只用于带内容哈希的条目
+    QByteArray key(8, '\0');
+    qToLittleEndian<quint64>(quint64(entry.uncompressedSize), key.data());
+    return key + entry.contentHash;
+}
+
+bool ExtractionEngine::appendTasks(int entryIndex)
+{
+    const ZipEntry &entry = m_entries->at(entryIndex);
+    Task task = { entryIndex, -1, 0, -1, entry.uncompressedSize, 0 };
+
+    int frameCount = 0;
+    int segmentFrames = 0;
+    if (m_frames && entry.method == ZipIndex::METHOD_LZ4_FRAMES) {
+        frameCount = m_frames->frameCount(entry.uncompressedSize);
+        segmentFrames = qMax(1, SEGMENT_SIZE / m_frames->frameSize);
+    }
+    if (frameCount <= segmentFrames) {
+        m_tasks.append(task);
+        return true;
+    }
+
+    // 先按最终大小创建文件，各段解压后写入各自的位置
+    if (!createSegmentedFile(entry)) {
+        if (m_metrics) {
+            m_metrics->addFailedCalls();
+        }
+        return false;
+    }
+    for (int first = 0; first < frameCount; first += segmentFrames) {
+        task.firstFrame = entry.firstFrame + first;
+        task.frameCount = qMin(segmentFrames, frameCount - first);
+        task.fileOffset = qint64(first) * m_frames->frameSize;
+        task.size = qMin(entry.uncompressedSize - task.fileOffset, qint64(task.frameCount) * m_frames->frameSize);
+        m_tasks.append(task);
+    }
+    return true;
+}
+
+bool ExtractionEngine::createSegmentedFile(const ZipEntry &entry)
+{
+    // 已有的文件可能和其他文件硬链接（以前用 --hardlink-duplicates 安装过），先删除再新建
+    QString fullPath = QDir(m_targetDir).absoluteFilePath(entry.filePath);
+    QFile::remove(fullPath);
+
+    // 先按最终大小分配空间再设置长度，各段并行写入时不会产生碎片
+    QFile file(fullPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    FileWriteBackend::preallocate(file, entry.uncompressedSize);
+    return file.resize(entry.uncompressedSize);
+}
+
+bool ExtractionEngine::extractEntry(EntryStreamer &streamer, BufferPool::Slab &slab, Task &task)
+{
+    const ZipEntry &entry = m_entries->at(task.entry);
+    const QString &fullPath = slab.outputPath(m_targetPrefix, entry.filePath);
+    bool segment = task.firstFrame >= 0;
+    TraceRecorder::Scope scope(segment ? "segment" : "entry", entry.filePath);
+
+    // 已有的文件由写盘后端先删除再新建，不会改写与它硬链接的文件；
+    // 分段写入的文件已经由 createSegmentedFile 准备好，上级目录都已由 DirectoryPlanner 创建
+
+    // 这个任务需要的压缩数据区间
+    qint64 offset = entry.dataOffset;
+    qint64 size = entry.compressedSize;
+    if (segment) {
+        int lastFrame = task.firstFrame + task.frameCount - 1;
+        offset = m_frames->offsets.at(task.firstFrame);
+        size = m_frames->offsets.at(lastFrame) + m_frames->compressedSize(lastFrame) - offset;
+    }
+
+    // 取得压缩数据：优先使用整体映射，否则单独映射这个区间
+    const uchar *data = nullptr;
+    uchar *regionMap = nullptr;
+    if (m_payload->isMapped()) {
+        data = m_payload->data() + offset;
+    } else if (size > 0) {
+        TraceRecorder::Scope readScope("read", entry.filePath);
+        regionMap = m_payload->mapRegion(offset, size);
+        if (!regionMap) {
+            return false;
+        }
+        data = regionMap;
+    }
+
+    bool ok = segment ? streamer.extractFrames(data, entry, task.firstFrame, task.frameCount, fullPath,
+                                               task.fileOffset, &task.crc)
+                      : streamer.extractEntry(data, entry, fullPath);
+    m_payload->unmapRegion(regionMap);
+    return ok;
+}
\ No newline at end of file
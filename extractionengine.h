@@ -0,0 +1,126 @@
+#ifndef EXTRACTIONENGINE_H
+#define EXTRACTIONENGINE_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+#include "bufferpool.h"
+#include "directoryplanner.h"
+#include "filecloner.h"
+#include "filewritebackend.h"
+#include "memorybudget.h"
+#include "zipindex.h"
+
+class PayloadDevice;
+class EntryStreamer;
+class InstallJournal;
+class InstallMetrics;
+class ProgressTracker;
+
+// 多线程解压引擎：条目按解压后大小从大到小轮流分给各个工作线程，
+// 自己的队列做完后从其他线程的队列尾部窃取剩余的小条目。
+// 分帧载荷中的大文件按帧切成若干段，由多个线程同时解压写入同一个文件
+class ExtractionEngine
+{
+public:
+    explicit ExtractionEngine(PayloadDevice *payload);
+
+    // 0 表示使用 QThread::idealThreadCount()
+    void setThreadCount(int threadCount);
+    int threadCount() const;
+
+    // 解压期间调用线程每隔 intervalMs 调用一次 callback，用于汇报进度
+    void setProgressTracker(ProgressTracker *tracker);
+    void setProgressCallback(const std::function<void()> &callback, int intervalMs);
+
+    // 记录创建目录、解压、写入的耗时和失败的文件操作
+    void setMetrics(InstallMetrics *metrics);
+
+    // 写完并校验过的文件记入断点续装日志
+    void setJournal(InstallJournal *journal);
+
+    // 内容相同（大小和安装清单中的内容哈希相同）的文件只解压一次，其余副本用 mode 创建；
+    // 没有内容哈希的条目不合并
+    void setDeduplication(bool enabled, FileCloner::Mode mode = FileCloner::Copy);
+    int duplicateCount() const;
+
+    // 最近一次 extract() 预先创建目录的统计
+    DirectoryPlanner::Stats directoryStats() const;
+
+    // 分帧载荷的帧表，ZIP 载荷不需要设置
+    void setFrameTable(const FrameTable *frames);
+
+    // 解压结果的写盘方式，不可用时退回 Portable
+    void setWriteBackend(FileWriteBackend::Kind kind);
+
+    // 解压缓冲的内存上限（字节），0 表示不限制；超出时缩小缓冲、减少工作线程
+    void setMemoryBudget(qint64 bytes);
+
+    // 最近一次 extract() 实际使用的线程数和缓冲；workers 为 0 表示上限内放不下一个线程
+    MemoryBudget::Plan memoryPlan() const;
+
+    // 缓冲池的累计分配和复用次数，多次 extract() 之间缓冲池保留
+    BufferPool::Stats bufferStats() const;
+
+    bool extract(const QVector<ZipEntry> &entries, const QString &targetDir);
+
+    // 分帧条目每段的目标大小
+    static const int SEGMENT_SIZE = 8 * 1024 * 1024;
+
+private:
+    // 一个解压任务：整个条目，或分帧条目中连续的若干帧
+    struct Task {
+        int entry;
+        int firstFrame;     // -1 表示整个条目
+        int frameCount;
+        qint64 fileOffset;
+        qint64 size;        // 解压后大小，用于排序
+        quint32 crc;        // 分段解压后这一段的 CRC
+    };
+
+    struct WorkQueue {
+        QMutex mutex;
+        QVector<int> tasks;
+        int head;
+    };
+
+    void workerLoop(int worker);
+    int takeTask(int worker);
+    int stealTask(int thief);
+    bool extractEntry(EntryStreamer &streamer, BufferPool::Slab &slab, Task &task);
+    bool verifySegments();
+    bool createSegmentedFile(const ZipEntry &entry);
+    bool appendTasks(int entryIndex);
+    bool cloneDuplicates();
+    static QByteArray contentKey(const ZipEntry &entry);
+
+    PayloadDevice *m_payload;
+    int m_threadCount;
+    ProgressTracker *m_progress;
+    InstallMetrics *m_metrics;
+    InstallJournal *m_journal;
+    std::function<void()> m_progressCallback;
+    int m_progressIntervalMs;
+    bool m_deduplicate;
+    FileCloner::Mode m_cloneMode;
+    FileWriteBackend::Kind m_writeBackend;
+    qint64 m_memoryBudget;
+    MemoryBudget::Plan m_memoryPlan;
+    QVector<QPair<int, int>> m_duplicates;  // (副本条目, 首个相同内容的条目)
+    DirectoryPlanner::Stats m_directoryStats;
+    QString m_targetDir;
+    QString m_targetPrefix;     // 安装目录的绝对路径加上 '/'，各线程在 slab 中拼接输出路径
+    BufferPool m_pool;
+    const QVector<ZipEntry> *m_entries;
+    const FrameTable *m_frames;
+    QVector<Task> m_tasks;
+    QVector<WorkQueue *> m_queues;
+    QAtomicInteger<int> m_aborted;
+};
+
+#endif // EXTRACTIONENGINE_H
\ No newline at end of file
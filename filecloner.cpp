@@ -0,0 +1,92 @@
+#include "filecloner.h"
+
+#include <QFile>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+bool FileCloner::clone(const QString &source, const QString &target, Mode mode)
+{
+    QFile::remove(target);
+
+    if (mode == Hardlink && createHardLink(source, target)) {
+        return true;
+    }
+    if (copyInKernel(source, target)) {
+        return true;
+    }
+
+    // Windows 上 QFile::copy 使用 CopyFile，由系统完成复制（ReFS 上会自动克隆数据块）
+    QFile::remove(target);
+    return QFile::copy(source, target);
+}
+
+bool FileCloner::createHardLink(const QString &source, const QString &target)
+{
+#if defined(Q_OS_WIN)
+    return CreateHardLinkW(reinterpret_cast<const wchar_t *>(target.utf16()),
+                           reinterpret_cast<const wchar_t *>(source.utf16()), nullptr);
+#else
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+
+bool FileCloner::copyInKernel(const QString &source, const QString &target)
+{
+#if defined(Q_OS_LINUX)
+    int in = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0) {
+        ::close(in);
+        return false;
+    }
+    int out = ::open(QFile::encodeName(target).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                     st.st_mode & 0777);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    // 先尝试共享数据块（btrfs、xfs 等），不支持时用 copy_file_range 在内核中复制
+    bool ok = ioctl(out, FICLONE, in) == 0;
+    if (!ok) {
+        off_t remaining = st.st_size;
+        ok = true;
+        while (remaining > 0) {
+            ssize_t copied = copy_file_range(in, nullptr, out, nullptr, size_t(remaining), 0);
+            if (copied < 0 && errno == EINTR) {
+                continue;
+            }
+            if (copied <= 0) {
+                ok = false;
+                break;
+            }
+            remaining -= copied;
+        }
+    }
+
+    ::close(in);
+    if (::close(out) != 0) {
+        ok = false;
+    }
+    return ok;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;
+#endif
+}
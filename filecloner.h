@@ -0,0 +1,24 @@
+#ifndef FILECLONER_H
+#define FILECLONER_H
+
+#include <QString>
+
+// 为内容相同的文件创建副本：硬链接、写时复制（reflink）或内核内复制，
+// 都不可用时退回普通复制
+class FileCloner
+{
+public:
+    enum Mode {
+        Copy,       // 独立的副本：reflink / copy_file_range / CopyFile
+        Hardlink    // 硬链接，失败时退回 Copy
+    };
+
+    // target 已存在时先删除
+    static bool clone(const QString &source, const QString &target, Mode mode);
+
+private:
+    static bool createHardLink(const QString &source, const QString &target);
+    static bool copyInKernel(const QString &source, const QString &target);
+};
+
+#endif // FILECLONER_H
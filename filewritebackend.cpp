@@ -0,0 +1,281 @@
+#include "filewritebackend.h"
+
+#if defined(Q_OS_LINUX)
+#include "iouringwritebackend.h"
+#endif
+
+#include <QStringEncoder>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_WIN)
+bool preallocateHandle(HANDLE handle, qint64 size)
+{
+    // 只设置分配大小，文件长度仍由写入决定
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = size;
+    return handle != INVALID_HANDLE_VALUE
+           && SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info));
+}
+#else
+// 新建文件的权限：所有者可读写，其他人只读
+const mode_t FILE_MODE = 0644;
+
+bool preallocateHandle(int fd, qint64 size)
+{
+#if defined(Q_OS_LINUX)
+    // 不用 posix_fallocate：文件系统不支持时它会退化成逐块写零
+    return ::fallocate(fd, 0, 0, size) == 0;
+#elif defined(Q_OS_MACOS)
+    // 先尝试连续分配，失败再允许分散的区段
+    fstore_t store = { F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0 };
+    if (::fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        return ::fcntl(fd, F_PREALLOCATE, &store) != -1;
+    }
+    return true;
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(size);
+    return false;
+#endif
+}
+#endif
+
+} // namespace
+
+FileWriteBackend::~FileWriteBackend()
+{
+}
+
+FileWriteBackend *FileWriteBackend::create(Kind kind, int maxPendingBuffers)
+{
+#if defined(Q_OS_LINUX)
+    if (kind == IoUring) {
+        IoUringWriteBackend *backend = new IoUringWriteBackend(maxPendingBuffers);
+        if (backend->isReady()) {
+            return backend;
+        }
+        delete backend;
+    }
+#else
+    Q_UNUSED(kind);
+    Q_UNUSED(maxPendingBuffers);
+#endif
+    return new PortableWriteBackend;
+}
+
+bool FileWriteBackend::parseKind(const QString &name, Kind &kind)
+{
+    if (name.compare(QLatin1String("portable"), Qt::CaseInsensitive) == 0) {
+        kind = Portable;
+        return true;
+    }
+    if (name.compare(QLatin1String("io_uring"), Qt::CaseInsensitive) == 0) {
+        kind = IoUring;
+        return true;
+    }
+    return false;
+}
+
+QString FileWriteBackend::kindName(Kind kind)
+{
+    return kind == IoUring ? QStringLiteral("io_uring") : QStringLiteral("portable");
+}
+
+bool FileWriteBackend::preallocate(QFile &file, qint64 size)
+{
+    if (size <= 0 || !file.isOpen()) {
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    return preallocateHandle(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())), size);
+#else
+    return preallocateHandle(file.handle(), size);
+#endif
+}
+
+void FileWriteBackend::encodePath(QStringView path, QByteArray &out)
+{
+    // Qt 6 在 Unix 上总是按 UTF-8 编码文件名，与 QFile::encodeName 一致
+    QStringEncoder encoder(QStringEncoder::Utf8);
+    out.resize(encoder.requiredSpace(path.size()));
+    char *end = encoder.appendToBuffer(out.data(), path);
+    out.resize(end - out.constData());
+}
+
+#if defined(Q_OS_WIN)
+void FileWriteBackend::toNativePath(QStringView path, QString &out)
+{
+    // 12 是 CreateDirectoryW 为 8.3 文件名预留的长度，目录和文件使用同一个阈值
+    out.truncate(0);
+    if (path.size() >= MAX_PATH - 12) {
+        if (path.startsWith(QLatin1String("//"))) {
+            out.append(QLatin1String("\\\\?\\UNC\\"));
+            out.append(path.mid(2));
+        } else {
+            out.append(QLatin1String("\\\\?\\"));
+            out.append(path);
+        }
+    } else {
+        out.append(path);
+    }
+    out.replace(QLatin1Char('/'), QLatin1Char('\\'));
+}
+#endif
+
+PortableWriteBackend::PortableWriteBackend()
+#if defined(Q_OS_WIN)
+    : m_handle(INVALID_HANDLE_VALUE)
+#else
+    : m_fd(-1)
+#endif
+{
+}
+
+PortableWriteBackend::~PortableWriteBackend()
+{
+    discard();
+}
+
+bool PortableWriteBackend::begin(const QString &path, qint64 fileOffset, qint64 fileSize)
+{
+    // 不经过任何用户态缓冲，缓冲块直接写入；分段写入的文件已经按最终大小创建好
+#if defined(Q_OS_WIN)
+    // 与 QFile 相同的共享方式：分段写入时多个写入线程同时打开同一个文件
+    toNativePath(path, m_nativePath);
+    if (fileOffset < 0) {
+        removeFile();
+    }
+    m_handle = CreateFileW(reinterpret_cast<const wchar_t *>(m_nativePath.utf16()), GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                           fileOffset < 0 ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER position;
+    position.QuadPart = fileOffset;
+    if (fileOffset > 0 && !SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN)) {
+        closeFile();
+        return false;
+    }
+#else
+    encodePath(path, m_nativePath);
+    if (fileOffset < 0) {
+        removeFile();
+    }
+    int flags = fileOffset < 0 ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_WRONLY | O_CLOEXEC;
+    m_fd = ::open(m_nativePath.constData(), flags, FILE_MODE);
+    if (m_fd < 0) {
+        return false;
+    }
+    if (fileOffset > 0 && ::lseek(m_fd, off_t(fileOffset), SEEK_SET) < 0) {
+        closeFile();
+        return false;
+    }
+#endif
+    if (fileOffset < 0 && fileSize >= PREALLOCATE_THRESHOLD) {
+#if defined(Q_OS_WIN)
+        preallocateHandle(m_handle, fileSize);
+#else
+        preallocateHandle(m_fd, fileSize);
+#endif
+    }
+    return true;
+}
+
+bool PortableWriteBackend::write(const char *data, qint64 size)
+{
+    while (size > 0) {
+#if defined(Q_OS_WIN)
+        DWORD written = 0;
+        if (!WriteFile(m_handle, data, DWORD(qMin<qint64>(size, 1 << 30)), &written, nullptr)) {
+            return false;
+        }
+#else
+        ssize_t written = ::write(m_fd, data, size_t(size));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+#endif
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool PortableWriteBackend::end()
+{
+#if !defined(Q_OS_WIN)
+    // 覆盖已有文件时 open 不会修改权限，这里统一设置为可读写
+    ::fchmod(m_fd, FILE_MODE);
+#endif
+    if (!closeFile()) {
+        removeFile();
+        return false;
+    }
+    return true;
+}
+
+void PortableWriteBackend::discard()
+{
+#if defined(Q_OS_WIN)
+    bool open = m_handle != INVALID_HANDLE_VALUE;
+#else
+    bool open = m_fd >= 0;
+#endif
+    if (open) {
+        closeFile();
+        removeFile();
+    }
+}
+
+bool PortableWriteBackend::closeFile()
+{
+#if defined(Q_OS_WIN)
+    bool closed = CloseHandle(m_handle);
+    m_handle = INVALID_HANDLE_VALUE;
+#else
+    bool closed = ::close(m_fd) == 0;
+    m_fd = -1;
+#endif
+    return closed;
+}
+
+void PortableWriteBackend::removeFile()
+{
+#if defined(Q_OS_WIN)
+    DeleteFileW(reinterpret_cast<const wchar_t *>(m_nativePath.utf16()));
+#else
+    ::unlink(m_nativePath.constData());
+#endif
+}
+
+bool PortableWriteBackend::complete()
+{
+    // 每个操作都是同步完成的
+    return true;
+}
+
+int PortableWriteBackend::maxPendingBuffers() const
+{
+    return 1;
+}
+
+FileWriteBackend::Kind PortableWriteBackend::kind() const
+{
+    return Portable;
+}
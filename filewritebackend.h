@@ -0,0 +1,89 @@
+#ifndef FILEWRITEBACKEND_H
+#define FILEWRITEBACKEND_H
+
+#include <QFile>
+#include <QString>
+
+// 解压结果的写盘方式。写入线程按顺序调用 begin / write / end，
+// 后端可以把这些操作攒起来批量提交，因此传给 write() 的数据在 complete() 返回之前不能复用
+class FileWriteBackend
+{
+public:
+    enum Kind {
+        Portable,   // 系统文件句柄，逐个文件同步 open/write/close
+        IoUring     // Linux io_uring，多个文件的 openat/write/close 一次提交
+    };
+
+    virtual ~FileWriteBackend();
+
+    // fileOffset 为 -1 时先删除已有的文件再新建，并按最终大小 fileSize 预先分配空间：
+    // 已有的文件可能是以前硬链接安装的副本，截断会改写共用数据的其他文件。
+    // 否则打开已有文件并从 fileOffset 开始写
+    virtual bool begin(const QString &path, qint64 fileOffset, qint64 fileSize) = 0;
+    virtual bool write(const char *data, qint64 size) = 0;
+    virtual bool end() = 0;
+
+    // 放弃当前正在写的文件：关闭并删除
+    virtual void discard() = 0;
+
+    // 等待已提交的操作全部完成，返回是否都成功；写失败的文件会被删除
+    virtual bool complete() = 0;
+
+    // 调用 complete() 之前最多可以交给后端多少块数据
+    virtual int maxPendingBuffers() const = 0;
+
+    virtual Kind kind() const = 0;
+
+    // 请求的后端在当前系统上不可用时退回 Portable
+    static FileWriteBackend *create(Kind kind, int maxPendingBuffers);
+
+    static bool parseKind(const QString &name, Kind &kind);
+    static QString kindName(Kind kind);
+
+    // 按最终大小一次性分配磁盘空间，让文件系统给出连续的区段，写入时不再逐次扩展文件；
+    // 只是优化，不支持的文件系统上返回 false，调用方照常写入即可
+    static bool preallocate(QFile &file, qint64 size);
+
+    // Unix：把路径编码成文件系统使用的字节串写入 out（以 '\0' 结尾），out 的容量足够时不分配
+    static void encodePath(QStringView path, QByteArray &out);
+
+#if defined(Q_OS_WIN)
+    // Windows：换成反斜杠写入 out；接近 MAX_PATH 的路径加 \\?\ 前缀，这种路径不再经过解析，
+    // path 必须是完整的绝对路径。out 的容量足够时不分配
+    static void toNativePath(QStringView path, QString &out);
+#endif
+
+    // 小于这个大小的文件一次写完，预分配只会多一次系统调用
+    static const qint64 PREALLOCATE_THRESHOLD = 1024 * 1024;
+};
+
+// 直接使用系统的文件句柄而不是 QFile：QFile 每打开一个文件都要分配文件引擎和本地路径，
+// 这里的路径暂存区在文件之间复用
+class PortableWriteBackend : public FileWriteBackend
+{
+public:
+    PortableWriteBackend();
+    ~PortableWriteBackend() override;
+
+    bool begin(const QString &path, qint64 fileOffset, qint64 fileSize) override;
+    bool write(const char *data, qint64 size) override;
+    bool end() override;
+    void discard() override;
+    bool complete() override;
+    int maxPendingBuffers() const override;
+    Kind kind() const override;
+
+private:
+    bool closeFile();
+    void removeFile();
+
+#if defined(Q_OS_WIN)
+    void *m_handle;         // HANDLE，没有打开的文件时为 INVALID_HANDLE_VALUE
+    QString m_nativePath;
+#else
+    int m_fd;
+    QByteArray m_nativePath;
+#endif
+};
+
+#endif // FILEWRITEBACKEND_H
@@ -0,0 +1,457 @@
+#include "inflater.h"
+
+#include <cstring>
+
+namespace {
+
+// 长度码 257..285 的基础值与附加位数
+const quint16 LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const quint8 LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+// 距离码 0..29 的基础值与附加位数
+const quint16 DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const quint8 DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// 动态块中码长码的排列顺序
+const quint8 CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+quint32 reverseBits(quint32 code, int length)
+{
+    quint32 result = 0;
+    for (int i = 0; i < length; i++) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+Inflater::Inflater()
+    : m_in(nullptr)
+    , m_inSize(0)
+    , m_inPos(0)
+    , m_bitBuffer(0)
+    , m_bitCount(0)
+    , m_state(Failed)
+    , m_lastBlock(false)
+    , m_storedRemaining(0)
+    , m_copyLength(0)
+    , m_copyDistance(0)
+    , m_totalOut(0)
+    , m_fixedBuilt(false)
+    , m_windowPos(0)
+{
+}
+
+void Inflater::reset(const uchar *input, qint64 inputSize)
+{
+    m_in = input;
+    m_inSize = inputSize;
+    m_inPos = 0;
+    m_bitBuffer = 0;
+    m_bitCount = 0;
+    m_state = BlockHeader;
+    m_lastBlock = false;
+    m_storedRemaining = 0;
+    m_copyLength = 0;
+    m_copyDistance = 0;
+    m_totalOut = 0;
+    m_windowPos = 0;
+}
+
+bool Inflater::atEnd() const
+{
+    return m_state == Finished;
+}
+
+bool Inflater::hasError() const
+{
+    return m_state == Failed;
+}
+
+qint64 Inflater::totalOut() const
+{
+    return m_totalOut;
+}
+
+qint64 Inflater::totalIn() const
+{
+    return m_inPos - m_bitCount / 8;
+}
+
+void Inflater::fail()
+{
+    m_state = Failed;
+}
+
+bool Inflater::needBits(int n)
+{
+    while (m_bitCount <= 56 && m_inPos < m_inSize) {
+        m_bitBuffer |= quint64(m_in[m_inPos++]) << m_bitCount;
+        m_bitCount += 8;
+    }
+    return m_bitCount >= n;
+}
+
+quint32 Inflater::getBits(int n)
+{
+    quint32 value = quint32(m_bitBuffer & ((quint64(1) << n) - 1));
+    dropBits(n);
+    return value;
+}
+
+void Inflater::dropBits(int n)
+{
+    m_bitBuffer >>= n;
+    m_bitCount -= n;
+}
+
+inline void Inflater::putByte(uchar *out, qint64 &produced, uchar b)
+{
+    out[produced++] = b;
+    m_window[m_windowPos++ & WINDOW_MASK] = b;
+    m_totalOut++;
+}
+
+bool Inflater::buildHuffman(Huffman &h, const quint8 *lengths, int n)
+{
+    memset(h.count, 0, sizeof(h.count));
+    memset(h.fast, 0, sizeof(h.fast));
+    for (int i = 0; i < n; i++) {
+        h.count[lengths[i]]++;
+    }
+
+    // 全部为零长度：合法（例如只有字面量的块不需要距离码）
+    if (h.count[0] == n) {
+        return true;
+    }
+
+    // 检查码表是否超额
+    int left = 1;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        left <<= 1;
+        left -= h.count[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    // 按码长排序符号（规范哈夫曼码）
+    quint16 offsets[MAX_BITS + 1];
+    offsets[1] = 0;
+    for (int len = 1; len < MAX_BITS; len++) {
+        offsets[len + 1] = offsets[len] + h.count[len];
+    }
+    for (int symbol = 0; symbol < n; symbol++) {
+        if (lengths[symbol] != 0) {
+            h.symbol[offsets[lengths[symbol]]++] = quint16(symbol);
+        }
+    }
+
+    // 短码直接填入快速查表，码值需要按位反转（DEFLATE 按低位优先读取）
+    quint32 nextCode[MAX_BITS + 1];
+    quint32 code = 0;
+    nextCode[0] = 0;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        code = (code + (len > 1 ? h.count[len - 1] : 0)) << 1;
+        nextCode[len] = code;
+    }
+    for (int symbol = 0; symbol < n; symbol++) {
+        int len = lengths[symbol];
+        if (len == 0) {
+            continue;
+        }
+        quint32 symbolCode = nextCode[len]++;
+        if (len > FAST_BITS) {
+            continue;
+        }
+        quint16 entry = quint16((symbol << 4) | len);
+        for (quint32 i = reverseBits(symbolCode, len); i < (1u << FAST_BITS); i += (1u << len)) {
+            h.fast[i] = entry;
+        }
+    }
+
+    return true;
+}
+
+int Inflater::decodeSymbol(const Huffman &h)
+{
+    needBits(MAX_BITS);
+
+    quint16 entry = h.fast[m_bitBuffer & ((1u << FAST_BITS) - 1)];
+    if (entry != 0 && (entry & 15) <= m_bitCount) {
+        dropBits(entry & 15);
+        return entry >> 4;
+    }
+
+    // 慢速路径：逐位匹配规范码
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        if (len > m_bitCount) {
+            return -1;
+        }
+        code |= int((m_bitBuffer >> (len - 1)) & 1);
+        int count = h.count[len];
+        if (code - count < first) {
+            dropBits(len);
+            return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+bool Inflater::readBlockHeader()
+{
+    if (!needBits(3)) {
+        return false;
+    }
+
+    m_lastBlock = getBits(1) != 0;
+    quint32 type = getBits(2);
+
+    if (type == 0) {
+        // 存储块：丢弃到字节边界后读取 LEN/NLEN
+        dropBits(m_bitCount & 7);
+        if (!needBits(32)) {
+            return false;
+        }
+        quint32 length = getBits(16);
+        quint32 inverted = getBits(16);
+        if (length != (~inverted & 0xffff)) {
+            return false;
+        }
+        m_storedRemaining = length;
+        m_state = StoredBlock;
+        return true;
+    }
+
+    if (type == 1) {
+        if (!m_fixedBuilt) {
+            quint8 lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; symbol++) lengths[symbol] = 8;
+            for (; symbol < 256; symbol++) lengths[symbol] = 9;
+            for (; symbol < 280; symbol++) lengths[symbol] = 7;
+            for (; symbol < 288; symbol++) lengths[symbol] = 8;
+            buildHuffman(m_fixedLengthCodes, lengths, 288);
+            for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+            buildHuffman(m_fixedDistanceCodes, lengths, 30);
+            m_fixedBuilt = true;
+        }
+        m_lengthCodes = m_fixedLengthCodes;
+        m_distanceCodes = m_fixedDistanceCodes;
+        m_state = HuffmanBlock;
+        return true;
+    }
+
+    if (type == 2) {
+        if (!readDynamicTables()) {
+            return false;
+        }
+        m_state = HuffmanBlock;
+        return true;
+    }
+
+    return false;
+}
+
+bool Inflater::readDynamicTables()
+{
+    if (!needBits(14)) {
+        return false;
+    }
+    int literalCount = int(getBits(5)) + 257;
+    int distanceCount = int(getBits(5)) + 1;
+    int codeLengthCount = int(getBits(4)) + 4;
+    if (literalCount > 286 || distanceCount > 30) {
+        return false;
+    }
+
+    quint8 lengths[288 + 32];
+    memset(lengths, 0, sizeof(lengths));
+    for (int i = 0; i < codeLengthCount; i++) {
+        if (!needBits(3)) {
+            return false;
+        }
+        lengths[CODE_LENGTH_ORDER[i]] = quint8(getBits(3));
+    }
+
+    Huffman codeLengthCodes;
+    if (!buildHuffman(codeLengthCodes, lengths, 19)) {
+        return false;
+    }
+
+    int total = literalCount + distanceCount;
+    int index = 0;
+    memset(lengths, 0, sizeof(lengths));
+    while (index < total) {
+        int symbol = decodeSymbol(codeLengthCodes);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = quint8(symbol);
+            continue;
+        }
+
+        int repeat = 0;
+        quint8 value = 0;
+        if (symbol == 16) {
+            if (index == 0 || !needBits(2)) {
+                return false;
+            }
+            value = lengths[index - 1];
+            repeat = 3 + int(getBits(2));
+        } else if (symbol == 17) {
+            if (!needBits(3)) {
+                return false;
+            }
+            repeat = 3 + int(getBits(3));
+        } else {
+            if (!needBits(7)) {
+                return false;
+            }
+            repeat = 11 + int(getBits(7));
+        }
+        if (index + repeat > total) {
+            return false;
+        }
+        while (repeat-- > 0) {
+            lengths[index++] = value;
+        }
+    }
+
+    // 块结束符必须有编码
+    if (lengths[256] == 0) {
+        return false;
+    }
+
+    return buildHuffman(m_lengthCodes, lengths, literalCount)
+        && buildHuffman(m_distanceCodes, lengths + literalCount, distanceCount);
+}
+
+qint64 Inflater::read(uchar *out, qint64 maxSize)
+{
+    qint64 produced = 0;
+
+    while (produced < maxSize) {
+        switch (m_state) {
+        case BlockHeader:
+            if (!readBlockHeader()) {
+                fail();
+                return -1;
+            }
+            break;
+
+        case StoredBlock: {
+            // 先取出位缓冲中剩余的整字节，再直接拷贝输入
+            while (m_storedRemaining > 0 && produced < maxSize && m_bitCount >= 8) {
+                putByte(out, produced, uchar(getBits(8)));
+                m_storedRemaining--;
+            }
+            qint64 chunk = qMin(m_storedRemaining, maxSize - produced);
+            chunk = qMin(chunk, m_inSize - m_inPos);
+            if (m_storedRemaining > 0 && produced < maxSize && chunk <= 0) {
+                fail();
+                return -1;
+            }
+            if (chunk > 0) {
+                const uchar *source = m_in + m_inPos;
+                memcpy(out + produced, source, size_t(chunk));
+                // 只需保留最后 32KB 作为历史窗口
+                qint64 keep = qMin(chunk, qint64(WINDOW_SIZE));
+                for (qint64 i = chunk - keep; i < chunk; i++) {
+                    m_window[(m_windowPos + quint32(i)) & WINDOW_MASK] = source[i];
+                }
+                m_windowPos += quint32(chunk);
+                m_inPos += chunk;
+                m_totalOut += chunk;
+                produced += chunk;
+                m_storedRemaining -= chunk;
+            }
+            if (m_storedRemaining == 0) {
+                m_state = m_lastBlock ? Finished : BlockHeader;
+            }
+            break;
+        }
+
+        case HuffmanBlock:
+            while (produced < maxSize) {
+                // 先完成上一次未输出完的回溯拷贝
+                if (m_copyLength > 0) {
+                    int n = int(qMin<qint64>(m_copyLength, maxSize - produced));
+                    for (int i = 0; i < n; i++) {
+                        putByte(out, produced, m_window[(m_windowPos - quint32(m_copyDistance)) & WINDOW_MASK]);
+                    }
+                    m_copyLength -= n;
+                    continue;
+                }
+
+                int symbol = decodeSymbol(m_lengthCodes);
+                if (symbol < 0) {
+                    fail();
+                    return -1;
+                }
+                if (symbol < 256) {
+                    putByte(out, produced, uchar(symbol));
+                    continue;
+                }
+                if (symbol == 256) {
+                    m_state = m_lastBlock ? Finished : BlockHeader;
+                    break;
+                }
+
+                symbol -= 257;
+                if (symbol >= 29 || !needBits(LENGTH_EXTRA[symbol])) {
+                    fail();
+                    return -1;
+                }
+                int length = LENGTH_BASE[symbol] + int(getBits(LENGTH_EXTRA[symbol]));
+
+                int distanceSymbol = decodeSymbol(m_distanceCodes);
+                if (distanceSymbol < 0 || distanceSymbol >= 30 || !needBits(DISTANCE_EXTRA[distanceSymbol])) {
+                    fail();
+                    return -1;
+                }
+                int distance = DISTANCE_BASE[distanceSymbol] + int(getBits(DISTANCE_EXTRA[distanceSymbol]));
+                if (distance > m_totalOut) {
+                    fail();
+                    return -1;
+                }
+
+                m_copyLength = length;
+                m_copyDistance = distance;
+            }
+            break;
+
+        case Finished:
+            return produced;
+
+        case Failed:
+            return -1;
+        }
+    }
+
+    return produced;
+}
\ No newline at end of file
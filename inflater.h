@@ -0,0 +1,81 @@
+#ifndef INFLATER_H
+#define INFLATER_H
+
+#include <QtGlobal>
+
+// 流式 raw DEFLATE 解码器（RFC 1951）
+// 输入为完整的压缩数据区间（通常直接指向映射的安装包），
+// 输出按调用方给定的缓冲区大小分段产生，内存占用固定为 32KB 历史窗口加码表
+class Inflater
+{
+public:
+    Inflater();
+
+    void reset(const uchar *input, qint64 inputSize);
+
+    // 解压最多 maxSize 字节到 out，返回实际写入字节数；出错返回 -1
+    qint64 read(uchar *out, qint64 maxSize);
+
+    bool atEnd() const;
+    bool hasError() const;
+    qint64 totalOut() const;
+
+    // 已消耗的压缩字节数（不含位缓冲中预读但未使用的整字节）
+    qint64 totalIn() const;
+
+private:
+    enum State {
+        BlockHeader,
+        StoredBlock,
+        HuffmanBlock,
+        Finished,
+        Failed
+    };
+
+    // 码长上限与快速查表位数
+    static const int MAX_BITS = 15;
+    static const int FAST_BITS = 10;
+    static const int WINDOW_SIZE = 32768;
+    static const int WINDOW_MASK = WINDOW_SIZE - 1;
+
+    struct Huffman {
+        quint16 count[MAX_BITS + 1];
+        quint16 symbol[288];
+        quint16 fast[1 << FAST_BITS]; // (symbol << 4) | length，0 表示需要走慢速路径
+    };
+
+    bool buildHuffman(Huffman &h, const quint8 *lengths, int n);
+    bool readBlockHeader();
+    bool readDynamicTables();
+    int decodeSymbol(const Huffman &h);
+    bool needBits(int n);
+    quint32 getBits(int n);
+    void dropBits(int n);
+    void fail();
+
+    inline void putByte(uchar *out, qint64 &produced, uchar b);
+
+    const uchar *m_in;
+    qint64 m_inSize;
+    qint64 m_inPos;
+    quint64 m_bitBuffer;
+    int m_bitCount;
+
+    State m_state;
+    bool m_lastBlock;
+    qint64 m_storedRemaining;
+    int m_copyLength;
+    int m_copyDistance;
+    qint64 m_totalOut;
+
+    Huffman m_lengthCodes;
+    Huffman m_distanceCodes;
+    bool m_fixedBuilt;
+    Huffman m_fixedLengthCodes;
+    Huffman m_fixedDistanceCodes;
+
+    uchar m_window[WINDOW_SIZE];
+    quint32 m_windowPos;
+};
+
+#endif // INFLATER_H
\ No newline at end of file
@@ -1,41 +1,76 @@
 #include "installer.h"
-#include <QApplication>
+#include "backgroundremover.h"
+#include "payloaddevice.h"
+#include "payloadlocator.h"
+#include "payloadverifier.h"
+#include "zipindex.h"
+#include "extractionengine.h"
+#include "installjournal.h"
+#include "stagedinstall.h"
+#include "tracerecorder.h"
+#include "upgradeplanner.h"
+#include <QCoreApplication>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QProcess>
 
 #include <QThread>
 #include <QTimer>
-#include <QDataStream>
 #include <QIODevice>
-#include <QtCore/private/qzipreader_p.h>
-
-// ZIP文件签名
-const QByteArray Installer::ZIP_SIGNATURE = QByteArray("PK\x03\x04");
-const QByteArray Installer::ZIP_END_SIGNATURE = QByteArray("PK\x05\x06");
 
 Installer::Installer(QObject *parent)
     : QObject(parent)
     , m_progressTimer(new QTimer(this))
+    , m_payload(nullptr)
+    , m_verifier(nullptr)
+    , m_remover(nullptr)
     , m_currentProgress(0)
+    , m_unchangedCount(0)
+    , m_resumedCount(0)
+    , m_obsoleteCount(0)
+    , m_staged(false)
 {
+    m_directoryStats = { 0, 0, 0, 0 };
+    m_memoryPlan = { 0, 0, 0, 0 };
+    m_bufferStats = { 0, 0, 0 };
 
     m_progressTimer->setSingleShot(true);
 }
 
 Installer::~Installer()
 {
-    cleanupTempFiles();
+    releasePayload();
+
+    // 退出前等后台删除完成，否则整个旧版本会一直留在回收目录里
+    if (m_remover) {
+        m_remover->wait();
+    }
+    delete m_remover;
 }
 
 void Installer::startInstallation()
 {
+    // Installer 已被移动到独立的工作线程，排队调用使安装在该线程中执行，
+    // 进度通过信号排队回到界面线程
+    QMetaObject::invokeMethod(this, &Installer::performInstallation, Qt::QueuedConnection);
+}
 
-    
-    // 在单独的线程中执行安装
-    QTimer::singleShot(100, this, &Installer::performInstallation);
+void Installer::sweepTrash()
+{
+    QMetaObject::invokeMethod(this, &Installer::performSweep, Qt::QueuedConnection);
+}
+
+void Installer::performSweep()
+{
+    if (m_remover) {
+        return;
+    }
+    m_remover = new BackgroundRemover(getInstallDirectory());
+    m_remover->start(m_options.threadCount);
 }
 
 void Installer::setInstallPath(const QString &path)
@@ -44,51 +79,165 @@ void Installer::setInstallPath(const QString &path)
 
 }
 
+void Installer::setOptions(const InstallOptions &options)
+{
+    m_options = options;
+}
+
 void Installer::performInstallation()
 {
+    m_metrics.reset();
+    m_unchangedCount = 0;
+    m_resumedCount = 0;
+    m_obsoleteCount = 0;
+    m_staged = false;
+    if (!m_options.tracePath.isEmpty()) {
+        TraceRecorder::start();
+        TraceRecorder::setThreadName("installer");
+    }
     try {
         updateProgress(0, "开始安装过程...");
         
-        // 步骤1: 从exe中提取压缩包
-        updateProgress(10, "正在从安装程序中提取文件...");
+        // 步骤1: 定位并映射exe中的压缩包，后台开始校验整个安装包
+        updateProgress(1, "正在定位安装包数据...");
+        m_metrics.beginPhase(InstallMetrics::Locate);
         if (!extractEmbeddedArchive()) {
-            emit errorOccurred("无法从安装程序中提取压缩包");
+            failInstallation("无法从安装程序中读取压缩包");
             return;
         }
         
-        updateProgress(30, "压缩包提取完成");
-        
-        // 步骤2: 创建安装目录
-        updateProgress(40, "正在创建安装目录...");
+        // 步骤2: 与已安装的文件比较（只读），校验通过后再开始改动磁盘
+        updateProgress(2, "正在比较已安装的文件...");
+        m_metrics.beginPhase(InstallMetrics::Validate);
         QString targetPath = getInstallDirectory();
-        if (!createDirectory(targetPath)) {
-            emit errorOccurred(QString("无法创建安装目录: %1").arg(targetPath));
+        UpgradePlanner planner(targetPath);
+        planner.plan(m_index.entries());
+        m_unchangedCount = planner.unchangedCount();
+        m_obsoleteCount = planner.obsoletePaths().size();
+        if (!m_verifier->wait()) {
+            releasePayload();
+            failInstallation("安装包已损坏或不完整，请重新下载安装程序");
             return;
         }
         
-        updateProgress(50, "安装目录创建完成");
+        // 新版本解压到安装目录旁边的临时目录，这期间旧版本照常可用；
+        // 临时目录无法创建时（例如上级目录不可写）退回原地升级：
+        // 旧文件移入回收目录，由后台线程删除（连同上次遗留的）。
+        // 上次用同一个安装包安装时被中断，临时目录中留有完成日志：保留临时目录，从中断处继续
+        m_metrics.beginPhase(InstallMetrics::Mkdir);
+        QByteArray payloadId = InstallJournal::payloadId(m_payloadHash, m_index.entries());
+        StagedInstall staging(targetPath);
+        bool staged = staging.prepare(InstallJournal::matches(staging.stagingDir(), payloadId));
+        m_staged = staged;
+        m_metrics.addFailedCalls(staging.failedCalls());
+        QString extractDir = staged ? staging.stagingDir() : targetPath;
+        // 启动时开始的清理如果还没结束先停下，剩下的由新的 BackgroundRemover 一起删除
+        delete m_remover;
+        m_remover = new BackgroundRemover(targetPath);
+        if (!staged) {
+            if (!createDirectory(targetPath)) {
+                m_metrics.addFailedCalls();
+                failInstallation(QString("无法创建安装目录: %1").arg(targetPath));
+                return;
+            }
+            m_metrics.beginPhase(InstallMetrics::DeleteOld);
+            planner.removeObsolete(m_remover);
+            m_remover->start(m_options.threadCount);
+        }
         
-        // 步骤3: 解压文件到安装目录
-        updateProgress(60, "正在解压文件...");
-        if (!extractArchiveToDirectory(m_tempArchivePath, targetPath)) {
-            emit errorOccurred("解压文件失败");
-            return;
+        // 完成日志：已经写完并校验过的文件逐个记录，日志打不开时照常安装，只是不能续装
+        m_metrics.beginPhase(InstallMetrics::Validate);
+        InstallJournal journal(extractDir);
+        bool journaled = journal.open(payloadId);
+        if (!journaled) {
+            m_metrics.addFailedCalls();
+        }
+        QVector<ZipEntry> pending = planner.pendingEntries();
+        if (journaled) {
+            pending = journal.filterCompleted(pending, m_options.threadCount);
+            m_resumedCount = journal.skippedCount();
         }
         
-        updateProgress(90, "文件解压完成");
+        // 步骤3: 只解压新增或变化的文件，进度按实际读写的字节数推进
+        QString extractMessage = QString("正在解压文件（%1 个文件未变化，%2 个旧文件将被删除）...")
+                                     .arg(m_unchangedCount)
+                                     .arg(m_obsoleteCount);
+        if (m_resumedCount > 0) {
+            extractMessage = QString("正在继续上次中断的安装（%1 个文件已完成，%2 个文件未变化）...")
+                                 .arg(m_resumedCount)
+                                 .arg(m_unchangedCount);
+        }
+        updateProgress(EXTRACT_PROGRESS_BEGIN, extractMessage);
+        m_metrics.beginPhase(InstallMetrics::Extract);
+        if (!extractArchiveToDirectory(m_payload, pending, extractDir, journaled ? &journal : nullptr)) {
+            // 已经完成的部分留在临时目录中，下次用同一个安装包安装时继续
+            journal.close();
+            if (staged && !journaled) {
+                staging.discard();
+            }
+            QString reason = "解压文件失败";
+            if (m_memoryPlan.workers == 0 && m_memoryPlan.bytes > 0) {
+                reason = QString("内存上限过小，解压至少需要 %1 KiB").arg((m_memoryPlan.bytes + 1023) / 1024);
+            }
+            failInstallation(staged ? reason + "，已安装的版本没有改动" : reason);
+            return;
+        }
+        journal.close();
         
-        // 步骤4: 清理临时文件
-        updateProgress(95, "正在清理临时文件...");
-        cleanupTempFiles();
+        // 步骤4: 记录本次安装的文件，释放安装包映射
+        updateProgress(EXTRACT_PROGRESS_END, QString("正在完成安装（%1 次 mkdir 创建了 %2 个目录，省去 %3 次逐级 mkpath）...")
+                                                 .arg(m_directoryStats.systemCalls)
+                                                 .arg(m_directoryStats.directories)
+                                                 .arg(m_directoryStats.mkpathCallsAvoided));
+        m_metrics.beginPhase(InstallMetrics::Cleanup);
+        if (staged) {
+            // 未变化的文件和用户自己的文件以硬链接带到新版本中，记录随临时目录一起切换；
+            // 旧版本只在两次改名之间不可用，之后整个移入回收目录，后台删除
+            QString previousDir;
+            if (!staging.carryOver(planner.retainedFiles())) {
+                m_metrics.addFailedCalls();
+                staging.discard();
+                failInstallation("无法准备新版本，已安装的版本没有改动");
+                return;
+            }
+            if (!planner.saveRecord(m_index.entries(), extractDir)) {
+                m_metrics.addFailedCalls();
+            }
+            if (!staging.commit(previousDir)) {
+                // 临时目录连同完成日志保留，重试时不需要再解压
+                m_metrics.addFailedCalls();
+                if (!journaled) {
+                    staging.discard();
+                }
+                failInstallation("无法替换已安装的版本，请关闭正在运行的 Ausic 后重试");
+                return;
+            }
+            InstallJournal::remove(targetPath);
+            m_metrics.beginPhase(InstallMetrics::DeleteOld);
+            if (!previousDir.isEmpty()) {
+                m_remover->moveAside(previousDir);
+            }
+            m_remover->start(m_options.threadCount);
+            m_metrics.beginPhase(InstallMetrics::Cleanup);
+        } else {
+            if (!planner.saveRecord(m_index.entries())) {
+                m_metrics.addFailedCalls();
+            }
+            InstallJournal::remove(targetPath);
+        }
+        releasePayload();
+        m_metrics.endPhase();
+        writeReport(targetPath);
+        saveTrace();
         
         updateProgress(100, "安装完成");
         
         emit installationFinished(true, "Ausic 安装成功完成!");
         
     } catch (const std::exception &e) {
-        emit errorOccurred(QString("安装过程中发生异常: %1").arg(e.what()));
+        failInstallation(QString("安装过程中发生异常: %1").arg(e.what()));
     } catch (...) {
-        emit errorOccurred("安装过程中发生未知错误");
+        failInstallation("安装过程中发生未知错误");
     }
 }
 
@@ -105,266 +254,64 @@ bool Installer::extractEmbeddedArchive()
     
     qint64 archiveOffset = 0;
     qint64 archiveSize = 0;
+    QByteArray manifest;
+    PayloadChecksum checksum;
     
-    if (!findArchiveInExecutable(exePath, archiveOffset, archiveSize)) {
+    if (!findArchiveInExecutable(exePath, archiveOffset, archiveSize, manifest, checksum)) {
         return false;
     }
+    m_payloadHash = checksum.isValid() ? checksum.rootHash : QByteArray();
     
-
+    // 整体校验与后面的清单解析、已安装文件比较同时进行
+    releasePayload();
+    m_verifier = new PayloadVerifier(exePath, archiveOffset, checksum);
+    m_verifier->setMemoryBudget(m_options.maxMemory);
+    m_verifier->start(m_options.threadCount);
     
-    // 创建临时目录
-    QString tempDir = getTempDirectory();
-    if (!createDirectory(tempDir)) {
-        return false;
-    }
 
     
-    m_tempArchivePath = tempDir + "/ausic_temp.zip";
-
-    
-    // 删除已存在的临时文件
-    if (QFile::exists(m_tempArchivePath)) {
-        QFile::remove(m_tempArchivePath);
-    }
-    
-    if (!copyArchiveFromExecutable(exePath, archiveOffset, archiveSize, m_tempArchivePath)) {
+    // 直接在exe的压缩包区间上建立只读视图，不再复制到临时文件
+    m_payload = new PayloadDevice(exePath, archiveOffset, archiveSize, this);
+    if (!m_payload->open(QIODevice::ReadOnly)) {
+        releasePayload();
         return false;
     }
     
-    return true;
-}
-
-bool Installer::findArchiveInExecutable(const QString &exePath, qint64 &archiveOffset, qint64 &archiveSize)
-{
-    QFile file(exePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
+    // 新格式安装包自带清单，直接得到条目列表，不再解析中央目录；
+    // 清单版本 2 表示载荷是分帧的 LZ4 数据而不是 ZIP
+    if (!manifest.isEmpty() && m_index.loadManifest(manifest, archiveSize)) {
+        return true;
     }
     
-    qint64 fileSize = file.size();
-    
-    // 新方法：查找魔术签名和元数据
-    const QByteArray MAGIC_SIGNATURE = QByteArray("AUSIC_ZIP_INFO");
-    const qint64 METADATA_SIZE = 14 + 8 + 8 + 4; // magic + offset + size + metadata_size
-    
-    if (fileSize < METADATA_SIZE) {
-        file.close();
+    // 不再预先试解压几个条目，完整性由解压时逐个条目校验 CRC 保证
+    if (!m_index.load(m_payload)) {
+        releasePayload();
         return false;
     }
     
-    // 读取文件末尾的元数据
-    file.seek(fileSize - METADATA_SIZE);
-    QByteArray metadataBlock = file.read(METADATA_SIZE);
-    
-    if (metadataBlock.size() != METADATA_SIZE) {
-        file.close();
-        return false;
-    }
-    
-    // 检查魔术签名
-    QByteArray magic = metadataBlock.left(14);
-    if (magic == MAGIC_SIGNATURE) {
-        // 解析元数据
-        QDataStream stream(metadataBlock.mid(14));
-        stream.setByteOrder(QDataStream::LittleEndian);
-        
-        quint64 zipOffset, zipSize;
-        quint32 metadataSize;
-        
-        stream >> zipOffset >> zipSize >> metadataSize;
-        
-        // 验证数据的合理性
-        if (zipOffset < fileSize && zipSize > 0 && 
-            zipOffset + zipSize <= fileSize - METADATA_SIZE) {
-            
-            // 验证ZIP文件头
-            file.seek(zipOffset);
-            QByteArray header = file.read(4);
-            
-            if (header == ZIP_SIGNATURE) {
-                // 进一步验证ZIP文件的完整性
-                // 检查ZIP结束记录是否在预期位置
-                qint64 expectedEndPos = zipOffset + zipSize - 22;
-                if (expectedEndPos >= 0 && expectedEndPos < fileSize - 22) {
-                    file.seek(expectedEndPos);
-                    QByteArray endSig = file.read(4);
-                    if (endSig == ZIP_END_SIGNATURE) {
-                        archiveOffset = zipOffset;
-                        archiveSize = zipSize;
-                        file.close();
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    
-    // 备用方法：使用旧的ZIP结束记录查找方法
-    // 首先从文件末尾查找ZIP结束记录
-    const qint64 maxEndRecordSize = 65557;
-    qint64 searchStart = qMax(0LL, fileSize - maxEndRecordSize);
-    
-    file.seek(searchStart);
-    QByteArray endData = file.read(fileSize - searchStart);
-    
-    // 从后往前搜索ZIP结束记录
-    for (int i = endData.size() - 22; i >= 0; i--) {
-        if (endData.mid(i, 4) == ZIP_END_SIGNATURE) {
-            // 读取ZIP结束记录中的信息
-            QDataStream stream(endData.mid(i));
-            stream.setByteOrder(QDataStream::LittleEndian);
-            
-            quint32 signature;
-            quint16 diskNumber, startDisk, entriesOnDisk, totalEntries;
-            quint32 centralDirSize, centralDirOffset;
-            quint16 commentLength;
-            
-            stream >> signature >> diskNumber >> startDisk >> entriesOnDisk 
-                   >> totalEntries >> centralDirSize >> centralDirOffset >> commentLength;
-            
-            // ZIP结束记录的绝对位置
-            qint64 zipEndRecordPos = searchStart + i;
-            
-            // 根据中央目录偏移计算ZIP文件开始位置
-            qint64 zipStartPos = zipEndRecordPos - centralDirOffset - centralDirSize;
-            
-            // ZIP文件结束位置（包含结束记录和注释）
-            qint64 zipEndPos = zipEndRecordPos + 22 + commentLength;
-            
-            // 验证ZIP文件头
-            file.seek(zipStartPos);
-            QByteArray header = file.read(4);
-            
-            if (header == ZIP_SIGNATURE && zipStartPos >= 0 && zipStartPos < fileSize) {
-                // 验证计算出的ZIP大小是否合理
-                qint64 calculatedSize = zipEndPos - zipStartPos;
-                if (calculatedSize > 0 && calculatedSize < fileSize && 
-                    zipEndPos <= fileSize) {
-                    archiveOffset = zipStartPos;
-                    archiveSize = calculatedSize;
-                    file.close();
-                    return true;
-                }
-            }
-        }
-    }
-    
-    // 最后的备用方法：从文件末尾向前搜索ZIP文件头
-    const qint64 maxSearchSize = qMin(fileSize, 200 * 1024 * 1024LL);
-    
-    for (qint64 pos = fileSize - 4; pos >= fileSize - maxSearchSize; pos--) {
-        file.seek(pos);
-        QByteArray header = file.read(4);
-        
-        if (header == ZIP_SIGNATURE) {
-            qint64 potentialSize = fileSize - pos;
-            // 验证这个位置的ZIP文件是否有有效的结束记录
-            if (potentialSize >= 22) {
-                file.seek(fileSize - 22);
-                QByteArray endSig = file.read(4);
-                if (endSig == ZIP_END_SIGNATURE) {
-                    archiveOffset = pos;
-                    archiveSize = potentialSize;
-                    file.close();
-                    return true;
-                }
-            }
-        }
-    }
-    
-    file.close();
-    return false;
+    return true;
 }
 
-bool Installer::copyArchiveFromExecutable(const QString &exePath, qint64 offset, qint64 size, const QString &outputPath)
+bool Installer::findArchiveInExecutable(const QString &exePath, qint64 &archiveOffset, qint64 &archiveSize,
+                                        QByteArray &manifest, PayloadChecksum &checksum)
 {
-    QFile sourceFile(exePath);
-    if (!sourceFile.open(QIODevice::ReadOnly)) {
+    // 末尾元数据、ZIP 结束记录、镜像结束位置之后的文件头，依次尝试
+    PayloadLocator locator(exePath);
+    if (!locator.locate(archiveOffset, archiveSize)) {
         return false;
     }
-    
-    // 验证文件大小和偏移量的合理性
-    qint64 fileSize = sourceFile.size();
-    if (offset < 0 || size <= 0 || offset + size > fileSize) {
-        sourceFile.close();
-        return false;
-    }
-    
-    if (!sourceFile.seek(offset)) {
-        sourceFile.close();
-        return false;
-    }
-    
-    // 分块读取大文件，避免内存问题
-    const qint64 CHUNK_SIZE = 1024 * 1024; // 1MB chunks
-    QFile outputFile(outputPath);
-    if (!outputFile.open(QIODevice::WriteOnly)) {
-        sourceFile.close();
-        return false;
-    }
-    
-    qint64 totalBytesRead = 0;
-    qint64 totalBytesWritten = 0;
-    
-    while (totalBytesRead < size) {
-        qint64 bytesToRead = qMin(CHUNK_SIZE, size - totalBytesRead);
-        QByteArray chunk = sourceFile.read(bytesToRead);
-        
-        if (chunk.isEmpty() && bytesToRead > 0) {
-            // 读取失败
-            sourceFile.close();
-            outputFile.close();
-            QFile::remove(outputPath);
-            return false;
-        }
-        
-        qint64 bytesWritten = outputFile.write(chunk);
-        if (bytesWritten != chunk.size()) {
-            // 写入失败
-            sourceFile.close();
-            outputFile.close();
-            QFile::remove(outputPath);
-            return false;
-        }
-        
-        totalBytesRead += chunk.size();
-        totalBytesWritten += bytesWritten;
-    }
-    
-    sourceFile.close();
-    
-    // 强制刷新到磁盘
-    outputFile.flush();
-    outputFile.close();
-    
-    // 验证总字节数
-    if (totalBytesWritten != size) {
-        QFile::remove(outputPath);
-        return false;
-    }
-    
-    // 验证提取的文件
-    if (!isValidZipFile(outputPath)) {
-        QFile::remove(outputPath);
-        return false;
-    }
-    
-    // 额外验证：检查文件大小
-    QFileInfo outputInfo(outputPath);
-    if (outputInfo.size() != size) {
-        QFile::remove(outputPath);
-        return false;
-    }
-    
+    manifest = locator.manifest();
+    checksum = locator.checksum();
     return true;
 }
 
-bool Installer::extractArchiveToDirectory(const QString &archivePath, const QString &targetDir)
+bool Installer::extractArchiveToDirectory(PayloadDevice *payload, const QVector<ZipEntry> &entries,
+                                          const QString &targetDir, InstallJournal *journal)
 {
 
     
-    // 检查源文件是否存在
-    if (!QFile::exists(archivePath)) {
+    // 检查压缩包视图是否可用（设备被关闭过时按需重新打开）
+    if (!payload || (!payload->isOpen() && !payload->open(QIODevice::ReadOnly))) {
         return false;
     }
     
@@ -373,104 +320,34 @@ bool Installer::extractArchiveToDirectory(const QString &archivePath, const QStr
         return false;
     }
     
-    // 使用Qt内置的ZIP解压功能
-    QZipReader zipReader(archivePath);
-    
-    if (!zipReader.isReadable()) {
+    // 多线程解压，每个线程内部解压与写盘重叠进行
+    m_progress.reset(entries);
+    ExtractionEngine engine(payload);
+    engine.setThreadCount(m_options.threadCount);
+    engine.setDeduplication(m_options.deduplicate,
+                            m_options.hardlinkDuplicates ? FileCloner::Hardlink : FileCloner::Copy);
+    engine.setWriteBackend(m_options.writeBackend);
+    if (m_index.isFramed()) {
+        engine.setFrameTable(&m_index.frames());
+    }
+    engine.setProgressTracker(&m_progress);
+    engine.setMetrics(&m_metrics);
+    engine.setJournal(journal);
+    engine.setMemoryBudget(m_options.maxMemory);
+    engine.setProgressCallback([this]() { reportExtractionProgress(); }, m_options.progressIntervalMs);
+    bool extracted = engine.extract(entries, targetDir);
+    m_directoryStats = engine.directoryStats();
+    m_memoryPlan = engine.memoryPlan();
+    m_bufferStats = engine.bufferStats();
+    if (!extracted) {
         return false;
     }
     
-
-    
-    // 获取ZIP文件中的所有条目
-    QList<QZipReader::FileInfo> fileInfos = zipReader.fileInfoList();
-
-    
-    int extractedCount = 0;
-    
-    // 逐个提取文件
-    for (const QZipReader::FileInfo &fileInfo : fileInfos) {
-        QString fileName = fileInfo.filePath;
-        QString fullPath = QDir(targetDir).absoluteFilePath(fileName);
-        
-
-        
-        if (fileInfo.isDir) {
-            // 创建目录
-            QDir().mkpath(fullPath);
-
-        } else {
-            // 创建文件的父目录
-            QFileInfo fileInfoObj(fullPath);
-            QDir().mkpath(fileInfoObj.absolutePath());
-            
-            // 提取文件内容
-            QByteArray fileData = zipReader.fileData(fileName);
-            
-            // 详细验证文件数据
-            if (fileInfo.size > 0 && fileData.isEmpty()) {
-                // 文件应该有内容但读取为空，这是一个严重错误
-                return false;
-            }
-            
-            // 验证读取的数据大小是否与预期一致
-            if (fileData.size() != fileInfo.size) {
-                // 数据大小不匹配
-                return false;
-            }
-            
-            QFile outputFile(fullPath);
-            if (!outputFile.open(QIODevice::WriteOnly)) {
-                return false;
-            }
-            
-            qint64 bytesWritten = 0;
-            if (fileInfo.size > 0) {
-                // 对于非空文件，写入数据
-                bytesWritten = outputFile.write(fileData);
-                if (bytesWritten != fileData.size()) {
-                    outputFile.close();
-                    QFile::remove(fullPath);
-                    return false;
-                }
-            }
-            
-            // 强制刷新缓冲区到磁盘
-            if (!outputFile.flush()) {
-                outputFile.close();
-                QFile::remove(fullPath);
-                return false;
-            }
-            
-            outputFile.close();
-            
-            // 验证文件是否正确创建
-            QFileInfo createdFileInfo(fullPath);
-            if (!createdFileInfo.exists()) {
-                return false;
-            }
-            
-            // 验证文件大小
-            if (createdFileInfo.size() != fileInfo.size) {
-                QFile::remove(fullPath);
-                return false;
-            }
-            
-            extractedCount++;
-            
-            // 设置文件权限为可读写
-            outputFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner | 
-                                    QFile::ReadGroup | QFile::ReadOther);
-        }
-    }
-    
-    zipReader.close();
-    
     // 验证解压结果
     QDir targetDirectory(targetDir);
-    QStringList entries = targetDirectory.entryList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    QStringList installed = targetDirectory.entryList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
     
-    if (entries.isEmpty()) {
+    if (installed.isEmpty()) {
         return false;
     }
     
@@ -479,13 +356,7 @@ bool Installer::extractArchiveToDirectory(const QString &archivePath, const QStr
 
 QString Installer::getCurrentExecutablePath()
 {
-    return QApplication::applicationFilePath();
-}
-
-QString Installer::getTempDirectory()
-{
-    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    return tempDir + "/AusicInstaller";
+    return QCoreApplication::applicationFilePath();
 }
 
 QString Installer::getInstallDirectory()
@@ -504,109 +375,91 @@ bool Installer::createDirectory(const QString &path)
     return dir.mkpath(path);
 }
 
-bool Installer::isValidZipFile(const QString &filePath)
+void Installer::releasePayload()
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
-    }
-    
-    qint64 fileSize = file.size();
-    if (fileSize < 22) { // ZIP文件最小大小（包含中央目录结束记录）
-        file.close();
-        return false;
-    }
-    
-    // 检查文件头是否为ZIP签名
-    QByteArray header = file.read(4);
-    
-    if (header != ZIP_SIGNATURE) {
-        file.close();
-        return false;
-    }
-    
-    // 验证ZIP结束记录
-    file.seek(fileSize - 22);
-    QByteArray endRecord = file.read(22);
-    file.close();
-    
-    if (endRecord.size() != 22 || endRecord.left(4) != ZIP_END_SIGNATURE) {
-        return false;
-    }
-    
-    // 解析ZIP结束记录
-    QDataStream stream(endRecord);
-    stream.setByteOrder(QDataStream::LittleEndian);
-    
-    quint32 signature;
-    quint16 diskNumber, startDisk, entriesOnDisk, totalEntries;
-    quint32 centralDirSize, centralDirOffset;
-    quint16 commentLength;
-    
-    stream >> signature >> diskNumber >> startDisk >> entriesOnDisk 
-           >> totalEntries >> centralDirSize >> centralDirOffset >> commentLength;
-    
-    // 验证中央目录的位置和大小是否合理
-    if (centralDirOffset >= fileSize || 
-        centralDirSize == 0 || 
-        centralDirOffset + centralDirSize > fileSize - 22 - commentLength) {
-        return false;
-    }
-    
-    // 使用QZipReader进一步验证文件完整性
-    QZipReader zipReader(filePath);
-    if (!zipReader.isReadable()) {
-        return false;
-    }
-    
-    // 尝试获取文件列表并验证条目数量
-    QList<QZipReader::FileInfo> fileInfos = zipReader.fileInfoList();
-    
-    // 验证文件条目数量是否与ZIP结束记录一致
-    if (fileInfos.size() != totalEntries) {
-        zipReader.close();
-        return false;
+    // 压缩包是直接映射的，没有临时文件需要清理，只需解除映射
+    if (m_payload) {
+        m_payload->close();
+        delete m_payload;
+        m_payload = nullptr;
     }
     
-    // 验证每个文件的完整性（检查前几个文件）
-    int checkCount = qMin(5, fileInfos.size()); // 只检查前5个文件避免性能问题
-    for (int i = 0; i < checkCount; i++) {
-        const QZipReader::FileInfo &info = fileInfos[i];
-        if (!info.isDir && info.size > 0) {
-            QByteArray data = zipReader.fileData(info.filePath);
-            // 如果文件应该有内容但读取为空，或大小不匹配，说明ZIP损坏
-            if (data.isEmpty() || data.size() != info.size) {
-                zipReader.close();
-                return false;
-            }
+    // 析构时等待尚未结束的校验线程
+    delete m_verifier;
+    m_verifier = nullptr;
+}
+
+void Installer::failInstallation(const QString &error)
+{
+    // 失败的阶段是当前正在计时的阶段
+    m_metrics.endPhase();
+    m_metrics.setFailure(error);
+    writeReport(getInstallDirectory());
+    saveTrace();
+    emit errorOccurred(error);
+}
+
+void Installer::writeReport(const QString &targetPath)
+{
+    // 各阶段耗时之外补充数据量：读取的压缩字节、写出的字节、文件和目录数，
+    // 以及按解压步骤总耗时计算的吞吐量
+    ProgressTracker::Snapshot snapshot = m_progress.snapshot();
+    double extractSeconds = m_metrics.phaseNsecs(InstallMetrics::Extract) / 1e9;
+    QJsonObject report = m_metrics.toJson();
+    report.insert("bytesIn", snapshot.compressedRead);
+    report.insert("bytesOut", snapshot.bytesWritten);
+    report.insert("files", snapshot.filesDone);
+    report.insert("directories", m_directoryStats.directories);
+    report.insert("mkdirCalls", m_directoryStats.systemCalls);
+    report.insert("unchangedFiles", m_unchangedCount);
+    report.insert("resumedFiles", m_resumedCount);
+    report.insert("obsoleteFiles", m_obsoleteCount);
+    report.insert("filesPerSec", extractSeconds > 0 ? snapshot.filesDone / extractSeconds : 0.0);
+    report.insert("mbPerSec", extractSeconds > 0 ? snapshot.bytesWritten / extractSeconds / (1024.0 * 1024.0) : 0.0);
+    report.insert("threads", m_options.threadCount > 0 ? m_options.threadCount : QThread::idealThreadCount());
+    report.insert("writeBackend", FileWriteBackend::kindName(m_options.writeBackend));
+    report.insert("maxMemory", m_options.maxMemory);
+    report.insert("extractWorkers", m_memoryPlan.workers);
+    report.insert("bufferMemory", m_memoryPlan.bytes);
+    // 缓冲池的分配次数只与线程数、缓冲块数有关，不随文件数增长
+    report.insert("bufferAllocations", m_bufferStats.allocations);
+    report.insert("bufferAllocatedBytes", m_bufferStats.allocatedBytes);
+    report.insert("bufferReuses", m_bufferStats.reuses);
+    report.insert("staged", m_staged);
+
+    // 与安装记录放在一起；安装目录不存在（例如安装失败且是全新安装）时写到临时目录
+    QString reportDir = QFileInfo(targetPath).isDir() ? targetPath : QDir::tempPath();
+    QString path = QDir(reportDir).filePath(QLatin1String(InstallMetrics::REPORT_FILE_NAME));
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+        if (!file.commit()) {
+            path.clear();
         }
+    } else {
+        path.clear();
     }
-    
-    zipReader.close();
-    return true;
+    emit reportWritten(path, report);
 }
 
-void Installer::cleanupTempFiles()
+void Installer::saveTrace()
 {
-    if (!m_tempArchivePath.isEmpty()) {
-        QFile::remove(m_tempArchivePath);
-        m_tempArchivePath.clear();
-    }
-    
-    // 清理临时目录
-    QString tempDir = getTempDirectory();
-    QDir dir(tempDir);
-    if (dir.exists()) {
-        dir.removeRecursively();
+    // 解压线程此时都已结束，各线程的事件缓冲区可以安全读取
+    if (TraceRecorder::isEnabled() && !TraceRecorder::save(m_options.tracePath)) {
+        qWarning("无法写入时间线文件 %s", qPrintable(m_options.tracePath));
     }
 }
 
+void Installer::reportExtractionProgress()
+{
+    ProgressTracker::Snapshot snapshot = m_progress.snapshot();
+    int span = EXTRACT_PROGRESS_END - EXTRACT_PROGRESS_BEGIN;
+    int percentage = EXTRACT_PROGRESS_BEGIN + int(snapshot.fraction * span);
+    updateProgress(percentage, ProgressTracker::formatMessage(snapshot));
+}
+
 void Installer::updateProgress(int percentage, const QString &message)
 {
     m_currentProgress = percentage;
     emit progressUpdated(percentage, message);
-    
-    // 给UI时间更新
-    QApplication::processEvents();
-    QThread::msleep(100);
 }
\ No newline at end of file
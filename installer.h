@@ -5,9 +5,36 @@
 #include <QThread>
 #include <QFile>
 #include <QDir>
+#include <QJsonObject>
 #include <QTimer>
 #include <QProcess>
 
+#include "bufferpool.h"
+#include "directoryplanner.h"
+#include "filewritebackend.h"
+#include "installmetrics.h"
+#include "memorybudget.h"
+#include "progresstracker.h"
+#include "zipindex.h"
+
+class BackgroundRemover;
+class InstallJournal;
+class PayloadDevice;
+class PayloadVerifier;
+struct PayloadChecksum;
+
+// 安装参数（来自命令行）
+struct InstallOptions
+{
+    int threadCount = 0;    // 解压线程数，0 表示按 CPU 核数自动选择
+    int progressIntervalMs = 16;    // 解压进度上报间隔，默认约为 60Hz 的一帧
+    bool deduplicate = true;        // 内容相同的文件只解压一次
+    bool hardlinkDuplicates = false;    // 副本用硬链接代替独立复制
+    FileWriteBackend::Kind writeBackend = FileWriteBackend::Portable;   // 解压结果的写盘方式
+    QString tracePath;              // 非空时把安装过程的时间线写到这个文件
+    qint64 maxMemory = 0;           // 校验和解压缓冲的内存上限（字节），0 表示不限制
+};
+
 class Installer : public QObject
 {
     Q_OBJECT
@@ -17,44 +44,71 @@ public:
     ~Installer();
     
     void startInstallation();
+
+    // 在安装线程中开始删除安装目录下以前遗留的回收目录，程序启动时调用；开始安装时由安装过程接管
+    void sweepTrash();
+
     void setInstallPath(const QString &path);
+    void setOptions(const InstallOptions &options);
     QString getInstallDirectory();
     
 signals:
     void progressUpdated(int percentage, const QString &message);
     void installationFinished(bool success, const QString &message);
     void errorOccurred(const QString &error);
+    // 安装结束（成功或失败）时写出的各阶段统计报告，在 installationFinished / errorOccurred 之前发出
+    void reportWritten(const QString &path, const QJsonObject &report);
     
 private slots:
     void performInstallation();
+    void performSweep();
     
 private:
     // 核心功能函数
     bool extractEmbeddedArchive();
-    bool extractArchiveToDirectory(const QString &archivePath, const QString &targetDir);
-    bool findArchiveInExecutable(const QString &exePath, qint64 &archiveOffset, qint64 &archiveSize);
-    bool copyArchiveFromExecutable(const QString &exePath, qint64 offset, qint64 size, const QString &outputPath);
+    bool extractArchiveToDirectory(PayloadDevice *payload, const QVector<ZipEntry> &entries,
+                                   const QString &targetDir, InstallJournal *journal = nullptr);
+    bool findArchiveInExecutable(const QString &exePath, qint64 &archiveOffset, qint64 &archiveSize,
+                                 QByteArray &manifest, PayloadChecksum &checksum);
     
     // 辅助函数
     QString getCurrentExecutablePath();
-    QString getTempDirectory();
     bool createDirectory(const QString &path);
-    bool isValidZipFile(const QString &filePath);
-    void cleanupTempFiles();
+    void releasePayload();
+    
+    // 记录失败的阶段和原因，写出统计报告后发出 errorOccurred
+    void failInstallation(const QString &error);
+    void writeReport(const QString &targetPath);
+    void saveTrace();
     
     // 进度更新
     void updateProgress(int percentage, const QString &message);
+    void reportExtractionProgress();
     
     // 成员变量
     QTimer *m_progressTimer;
-    QString m_tempArchivePath;
+    PayloadDevice *m_payload;
+    PayloadVerifier *m_verifier;
+    BackgroundRemover *m_remover;   // 安装结束后继续在后台删除旧文件，析构时等待删完
     QString m_installPath;
+    InstallOptions m_options;
     int m_currentProgress;
+    ProgressTracker m_progress;
+    ZipIndex m_index;
+    QByteArray m_payloadHash;   // 安装包整体校验的根哈希，没有时为空
+    DirectoryPlanner::Stats m_directoryStats;
+    MemoryBudget::Plan m_memoryPlan;
+    BufferPool::Stats m_bufferStats;
+    InstallMetrics m_metrics;
+    int m_unchangedCount;
+    int m_resumedCount;     // 上次中断前已经完成、这次跳过的文件
+    int m_obsoleteCount;
+    bool m_staged;
     
     // 常量
-    static const QByteArray ZIP_SIGNATURE;
-    static const QByteArray ZIP_END_SIGNATURE;
-    static const int BUFFER_SIZE = 8192;
+    // 解压阶段在总进度条中占的区间，其余步骤耗时可以忽略
+    static const int EXTRACT_PROGRESS_BEGIN = 3;
+    static const int EXTRACT_PROGRESS_END = 99;
 };
 
 #endif // INSTALLER_H
\ No newline at end of file
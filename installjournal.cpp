@@ -0,0 +1,254 @@
+#include "installjournal.h"
+#include "crc32.h"
+#include "upgradeplanner.h"
+
+#include <QAtomicInteger>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtEndian>
+
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 头部：魔数、版本、标识长度、标识；之后是固定长度的记录
+const char JOURNAL_MAGIC[] = "AUSICJNL";
+const int JOURNAL_MAGIC_SIZE = 8;
+const quint32 JOURNAL_VERSION = 1;
+
+// 记录：条目序号 (u32)、大小 (u64)、CRC (u32)、前 16 字节的校验 (u32)，小端
+const int RECORD_SIZE = 20;
+const int RECORD_BODY_SIZE = 16;
+
+// 数据写到磁盘上之后才返回，机器重启也不会丢失已经同步的记录
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+#elif defined(Q_OS_LINUX)
+    return ::fdatasync(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+const char InstallJournal::JOURNAL_FILE_NAME[] = ".ausic_journal";
+
+InstallJournal::InstallJournal(const QString &dir)
+    : m_dir(dir)
+    , m_pendingCount(0)
+    , m_skipped(0)
+{
+    m_file.setFileName(QDir(dir).filePath(QLatin1String(JOURNAL_FILE_NAME)));
+}
+
+InstallJournal::~InstallJournal()
+{
+    close();
+}
+
+QByteArray InstallJournal::payloadId(const QByteArray &rootHash, const QVector<ZipEntry> &entries)
+{
+    if (!rootHash.isEmpty()) {
+        return rootHash;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+    uchar fields[12];
+    for (const ZipEntry &entry : entries) {
+        hash.addData(entry.filePath.toUtf8());
+        qToLittleEndian<quint64>(quint64(entry.uncompressedSize), fields);
+        qToLittleEndian<quint32>(entry.crc32, fields + 8);
+        hash.addData(QByteArrayView(fields, sizeof(fields)));
+    }
+    return hash.result();
+}
+
+QByteArray InstallJournal::header(const QByteArray &payloadId)
+{
+    QByteArray data(JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+    uchar fields[8];
+    qToLittleEndian<quint32>(JOURNAL_VERSION, fields);
+    qToLittleEndian<quint32>(quint32(payloadId.size()), fields + 4);
+    data.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+    data.append(payloadId);
+    return data;
+}
+
+bool InstallJournal::matches(const QString &dir, const QByteArray &payloadId)
+{
+    QFile file(QDir(dir).filePath(QLatin1String(JOURNAL_FILE_NAME)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray expected = header(payloadId);
+    return file.read(expected.size()) == expected;
+}
+
+bool InstallJournal::open(const QByteArray &payloadId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_completed.clear();
+    m_pending.clear();
+    m_pendingCount = 0;
+
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    // 同一个安装包的日志：读出完整的记录，从最后一条完整记录之后继续追加
+    QByteArray expected = header(payloadId);
+    QByteArray data = m_file.readAll();
+    qint64 validEnd = 0;
+    if (data.startsWith(expected)) {
+        validEnd = expected.size();
+        const uchar *records = reinterpret_cast<const uchar *>(data.constData());
+        while (validEnd + RECORD_SIZE <= data.size()) {
+            const uchar *record = records + validEnd;
+            if (Crc32::update(0, record, RECORD_BODY_SIZE) != qFromLittleEndian<quint32>(record + 16)) {
+                break;
+            }
+            Record completed;
+            completed.size = qint64(qFromLittleEndian<quint64>(record + 4));
+            completed.crc32 = qFromLittleEndian<quint32>(record + 12);
+            m_completed.insert(int(qFromLittleEndian<quint32>(record)), completed);
+            validEnd += RECORD_SIZE;
+        }
+    }
+
+    // 没有日志或安装包不同：重新开始
+    if (validEnd == 0) {
+        m_completed.clear();
+        if (!m_file.resize(0) || !m_file.seek(0) || m_file.write(expected) != expected.size()
+            || !syncFile(m_file)) {
+            m_file.close();
+            return false;
+        }
+        return true;
+    }
+    return m_file.resize(validEnd) && m_file.seek(validEnd);
+}
+
+QVector<ZipEntry> InstallJournal::filterCompleted(const QVector<ZipEntry> &entries, int threadCount)
+{
+    // 日志中的大小和 CRC 与这次的条目一致，才需要再检查磁盘上的文件
+    QVector<int> candidates;
+    for (int i = 0; i < entries.size(); i++) {
+        const ZipEntry &entry = entries.at(i);
+        auto record = m_completed.constFind(entry.index);
+        if (!entry.isDir && record != m_completed.constEnd() && record->size == entry.uncompressedSize
+            && record->crc32 == entry.crc32) {
+            candidates.append(i);
+        }
+    }
+
+    // 日志只保证记录本身已经落盘，文件数据可能在重启时丢失，逐个校验文件内容；
+    // 读取比重新解压、写入快得多，多个线程并行进行
+    QVector<char> verified(entries.size(), 0);
+    char *verifiedData = verified.data();   // 各线程直接写入，避免并发调用 QVector::operator[]
+    QAtomicInteger<int> next(0);
+    QDir dir(m_dir);
+    auto verify = [&]() {
+        forever {
+            int candidate = next.fetchAndAddRelaxed(1);
+            if (candidate >= candidates.size()) {
+                break;
+            }
+            const ZipEntry &entry = entries.at(candidates.at(candidate));
+            QString path = dir.filePath(entry.filePath);
+            quint32 crc = 0;
+            verifiedData[candidates.at(candidate)] = QFileInfo(path).size() == entry.uncompressedSize
+                                                 && UpgradePlanner::fileCrc32(path, crc) && crc == entry.crc32;
+        }
+    };
+    int workerCount = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    workerCount = qMin(workerCount, int(candidates.size()));
+    QVector<QThread *> workers;
+    for (int i = 1; i < workerCount; i++) {
+        QThread *thread = QThread::create(verify);
+        workers.append(thread);
+        thread->start();
+    }
+    verify();
+    for (QThread *thread : std::as_const(workers)) {
+        thread->wait();
+        delete thread;
+    }
+
+    QVector<ZipEntry> remaining;
+    remaining.reserve(entries.size());
+    m_skipped = 0;
+    for (int i = 0; i < entries.size(); i++) {
+        if (verified.at(i)) {
+            m_skipped++;
+        } else {
+            remaining.append(entries.at(i));
+        }
+    }
+    return remaining;
+}
+
+int InstallJournal::skippedCount() const
+{
+    return m_skipped;
+}
+
+void InstallJournal::append(const ZipEntry &entry)
+{
+    uchar record[RECORD_SIZE];
+    qToLittleEndian<quint32>(quint32(entry.index), record);
+    qToLittleEndian<quint64>(quint64(entry.uncompressedSize), record + 4);
+    qToLittleEndian<quint32>(entry.crc32, record + 12);
+    qToLittleEndian<quint32>(Crc32::update(0, record, RECORD_BODY_SIZE), record + 16);
+
+    QMutexLocker locker(&m_mutex);
+    m_pending.append(reinterpret_cast<const char *>(record), RECORD_SIZE);
+    if (++m_pendingCount >= SYNC_BATCH) {
+        writePending();
+    }
+}
+
+bool InstallJournal::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    return writePending();
+}
+
+bool InstallJournal::writePending()
+{
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+    // 日志写不进去只是失去续装的能力，不影响这次安装
+    bool written = m_file.isOpen() && m_file.write(m_pending) == m_pending.size() && syncFile(m_file);
+    m_pending.truncate(0);  // 保留容量，下一批记录不再分配
+    m_pendingCount = 0;
+    return written;
+}
+
+void InstallJournal::close()
+{
+    QMutexLocker locker(&m_mutex);
+    writePending();
+    m_file.close();
+}
+
+bool InstallJournal::remove(const QString &dir)
+{
+    return QFile::remove(QDir(dir).filePath(QLatin1String(JOURNAL_FILE_NAME)));
+}
@@ -0,0 +1,73 @@
+#ifndef INSTALLJOURNAL_H
+#define INSTALLJOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "zipindex.h"
+
+// 断点续装：解压目录中只追加写入的完成日志，每条记录一个已经写入并校验过的条目
+// （条目在安装包中的序号、大小和 CRC），攒够一批后写入并同步到磁盘。
+// 日志头部记录安装包的标识，安装被中断（进程被结束、机器重启）后用同一个安装包重新安装时，
+// 日志中记录过、且磁盘上内容仍然一致的文件不再解压，只完成剩下的部分
+class InstallJournal
+{
+public:
+    explicit InstallJournal(const QString &dir);
+    ~InstallJournal();
+
+    // 安装包的标识：有整体校验值时就是它的根哈希，否则由条目列表（路径、大小、CRC）计算
+    static QByteArray payloadId(const QByteArray &rootHash, const QVector<ZipEntry> &entries);
+
+    // dir 中已有同一个安装包的日志
+    static bool matches(const QString &dir, const QByteArray &payloadId);
+
+    // 读取已有的记录并准备追加；没有日志或安装包不同时新建。
+    // 最后一批写到一半被中断时，截掉不完整的记录
+    bool open(const QByteArray &payloadId);
+
+    // 去掉日志中记录过、磁盘上的文件大小和 CRC 仍然一致的文件条目，返回剩下的条目；
+    // 0 表示按 CPU 核数选择校验线程数
+    QVector<ZipEntry> filterCompleted(const QVector<ZipEntry> &entries, int threadCount);
+    int skippedCount() const;
+
+    // 任意线程：entry 已经写入并校验
+    void append(const ZipEntry &entry);
+
+    // 写入并同步还没写出的记录
+    bool flush();
+
+    // 写出剩余的记录并关闭文件；目录改名之前必须关闭（Windows 上打开的文件会阻止改名）
+    void close();
+
+    // 安装完成后删除 dir 中的日志
+    static bool remove(const QString &dir);
+
+    static const char JOURNAL_FILE_NAME[];
+
+    // 每攒够这么多条记录同步一次，同步的开销分摊到多个文件上
+    static const int SYNC_BATCH = 256;
+
+private:
+    struct Record {
+        qint64 size;
+        quint32 crc32;
+    };
+
+    static QByteArray header(const QByteArray &payloadId);
+    bool writePending();
+
+    QString m_dir;
+    QFile m_file;
+    QMutex m_mutex;
+    QByteArray m_pending;
+    int m_pendingCount;
+    QHash<int, Record> m_completed;     // 按条目序号
+    int m_skipped;
+};
+
+#endif // INSTALLJOURNAL_H
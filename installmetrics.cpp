@@ -0,0 +1,133 @@
+#include "installmetrics.h"
+
+#include "tracerecorder.h"
+
+#include <QJsonArray>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// 报告中的键名，同时作为时间线上的阶段名
+const char *const PHASE_NAMES[InstallMetrics::PhaseCount] = {
+    "locate", "validate", "deleteOld", "mkdir", "extract", "inflate", "write", "flush", "cleanup"
+};
+
+} // namespace
+
+const char InstallMetrics::REPORT_FILE_NAME[] = ".ausic_install_report.json";
+
+InstallMetrics::InstallMetrics()
+{
+    reset();
+}
+
+void InstallMetrics::reset()
+{
+    for (QAtomicInteger<qint64> &nsecs : m_nsecs) {
+        nsecs.storeRelaxed(0);
+    }
+    m_failedCalls.storeRelaxed(0);
+    m_current = Locate;
+    m_inPhase = false;
+    m_failure.clear();
+    m_total.start();
+}
+
+void InstallMetrics::beginPhase(Phase phase)
+{
+    endPhase();
+    m_current = phase;
+    m_inPhase = true;
+    m_phaseTimer.start();
+    TraceRecorder::begin(PHASE_NAMES[phase]);
+}
+
+void InstallMetrics::endPhase()
+{
+    if (m_inPhase) {
+        addTime(m_current, m_phaseTimer.nsecsElapsed());
+        m_inPhase = false;
+        TraceRecorder::end(PHASE_NAMES[m_current]);
+    }
+}
+
+InstallMetrics::Phase InstallMetrics::currentPhase() const
+{
+    return m_current;
+}
+
+void InstallMetrics::addTime(Phase phase, qint64 nsecs)
+{
+    m_nsecs[phase].fetchAndAddRelaxed(nsecs);
+}
+
+void InstallMetrics::addFailedCalls(int count)
+{
+    m_failedCalls.fetchAndAddRelaxed(count);
+}
+
+qint64 InstallMetrics::phaseNsecs(Phase phase) const
+{
+    return m_nsecs[phase].loadRelaxed();
+}
+
+void InstallMetrics::setFailure(const QString &message)
+{
+    m_failure = message;
+}
+
+QJsonObject InstallMetrics::toJson() const
+{
+    QJsonObject phases;
+    for (int i = 0; i < PhaseCount; i++) {
+        phases.insert(phaseName(Phase(i)), m_nsecs[i].loadRelaxed() / 1e6);
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("success"), m_failure.isEmpty());
+    if (!m_failure.isEmpty()) {
+        report.insert(QStringLiteral("failedPhase"), phaseName(m_current));
+        report.insert(QStringLiteral("error"), m_failure);
+    }
+    report.insert(QStringLiteral("totalMs"), m_total.nsecsElapsed() / 1e6);
+    report.insert(QStringLiteral("phasesMs"), phases);
+    report.insert(QStringLiteral("threadSummedPhases"),
+                  QJsonArray({ phaseName(Inflate), phaseName(Write), phaseName(Flush) }));
+    report.insert(QStringLiteral("failedSyscalls"), m_failedCalls.loadRelaxed());
+    report.insert(QStringLiteral("peakRssKb"), peakRssKb());
+    return report;
+}
+
+QString InstallMetrics::phaseName(Phase phase)
+{
+    return QString::fromLatin1(PHASE_NAMES[phase]);
+}
+
+qint64 InstallMetrics::peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    // K32 版本由 kernel32 导出，不需要链接 psapi
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return qint64(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_MACOS)
+    // macOS 上 ru_maxrss 以字节为单位，Linux 上以 KiB 为单位
+    return qint64(usage.ru_maxrss) / 1024;
+#else
+    return qint64(usage.ru_maxrss);
+#endif
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef INSTALLMETRICS_H
+#define INSTALLMETRICS_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+
+// 安装各阶段的耗时与失败的系统调用数，安装结束后和进度统计一起写成 JSON 报告
+// （安装目录中与安装记录并列的 REPORT_FILE_NAME），用来区分客户机器上安装慢的原因：
+// 解压受 CPU 限制、存储慢，还是文件操作被杀毒软件拦截。
+// 顺序阶段由安装线程计时；解压、写入、刷新在多个线程中同时进行，记录的是各线程耗时之和
+class InstallMetrics
+{
+public:
+    enum Phase {
+        Locate,     // 定位、映射安装包，读取清单或中央目录
+        Validate,   // 与已安装的文件比较，等待整体校验
+        DeleteOld,  // 旧文件移入回收目录
+        Mkdir,      // 创建安装目录、临时目录和安装包中的全部目录
+        Extract,    // 解压步骤的总耗时（包括其中的 Mkdir）
+        Inflate,    // 解压线程：解压 / 复制数据
+        Write,      // 写入线程：打开文件、提交数据
+        Flush,      // 写入线程：关闭文件、等待批量提交的写入完成
+        Cleanup,    // 带入未变化的文件、保存安装记录、切换版本、释放安装包
+        PhaseCount
+    };
+
+    InstallMetrics();
+
+    void reset();
+
+    // 安装线程：结束当前的顺序阶段（如果有），开始计时 phase
+    void beginPhase(Phase phase);
+    void endPhase();
+    Phase currentPhase() const;
+
+    // 任意线程：累加一段耗时或失败的系统调用
+    void addTime(Phase phase, qint64 nsecs);
+    void addFailedCalls(int count = 1);
+
+    qint64 phaseNsecs(Phase phase) const;
+
+    void setFailure(const QString &message);
+
+    // 阶段耗时、失败信息和进程峰值内存；字节数、文件数等由调用方补充
+    QJsonObject toJson() const;
+
+    static QString phaseName(Phase phase);
+
+    // 进程的峰值常驻内存（KiB），无法获取时返回 -1
+    static qint64 peakRssKb();
+
+    static const char REPORT_FILE_NAME[];
+
+private:
+    QAtomicInteger<qint64> m_nsecs[PhaseCount];
+    QAtomicInteger<int> m_failedCalls;
+    QElapsedTimer m_total;
+    QElapsedTimer m_phaseTimer;
+    Phase m_current;
+    bool m_inPhase;
+    QString m_failure;
+};
+
+#endif // INSTALLMETRICS_H
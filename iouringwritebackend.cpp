@@ -0,0 +1,410 @@
+#include "iouringwritebackend.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 每块数据最多对应 unlinkat、openat、fallocate、write、close 五个 SQE
+const int SQES_PER_BUFFER = 5;
+const int FILE_MODE = 0644;
+
+// 结果不影响文件是否写成功的操作（删除旧文件、预分配）
+const quint32 IGNORE_RESULT = 0xffffffff;
+
+int ioUringSetup(unsigned entries, io_uring_params *params)
+{
+    return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return int(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void *arg, unsigned count)
+{
+    return int(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// user_data：高 32 位为槽号加一，低 32 位为期望的返回值
+// （write 的长度；openat/close 为 0 表示只要不失败；IGNORE_RESULT 表示不检查）
+quint64 userData(int slot, quint32 expected)
+{
+    return (quint64(slot + 1) << 32) | expected;
+}
+
+} // namespace
+
+IoUringWriteBackend::IoUringWriteBackend(int maxPendingBuffers)
+    : m_ringFd(-1)
+    , m_maxPendingBuffers(qMax(1, maxPendingBuffers))
+    , m_sqRing(MAP_FAILED)
+    , m_cqRing(MAP_FAILED)
+    , m_sqRingSize(0)
+    , m_cqRingSize(0)
+    , m_sqes(nullptr)
+    , m_sqesSize(0)
+    , m_sqHead(nullptr)
+    , m_sqTail(nullptr)
+    , m_sqMask(nullptr)
+    , m_sqArray(nullptr)
+    , m_sqEntries(0)
+    , m_cqHead(nullptr)
+    , m_cqTail(nullptr)
+    , m_cqMask(nullptr)
+    , m_cqes(nullptr)
+    , m_toSubmit(0)
+    , m_inFlight(0)
+    , m_linkTail(nullptr)
+    , m_nextSlot(0)
+    , m_currentSlot(-1)
+    , m_position(0)
+    , m_failed(false)
+{
+    // 每个文件至少占用一块数据，complete() 之前开始的文件不会超过 maxPendingBuffers 个，
+    // 再加上跨越 complete() 仍在写的一个文件
+    m_slots.resize(m_maxPendingBuffers * 2 + 2);
+    for (Slot &slot : m_slots) {
+        slot.failed = false;
+    }
+
+    if (!setup(unsigned(m_maxPendingBuffers * SQES_PER_BUFFER + 4)) || !probe()) {
+        if (m_ringFd >= 0) {
+            ::close(m_ringFd);
+            m_ringFd = -1;
+        }
+    }
+}
+
+IoUringWriteBackend::~IoUringWriteBackend()
+{
+    if (m_ringFd >= 0) {
+        discard();
+        submitAndWait();
+    }
+
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing != MAP_FAILED) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    // 关闭 io_uring 时内核同时关闭固定文件槽中的文件
+    if (m_ringFd >= 0) {
+        ::close(m_ringFd);
+    }
+}
+
+bool IoUringWriteBackend::isReady() const
+{
+    return m_ringFd >= 0;
+}
+
+bool IoUringWriteBackend::setup(unsigned entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = ioUringSetup(entries, &params);
+    if (m_ringFd < 0) {
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        return false;
+    }
+    m_cqRing = singleMap ? m_sqRing
+                         : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                m_ringFd, IORING_OFF_CQ_RING);
+    if (m_cqRing == MAP_FAILED) {
+        return false;
+    }
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    m_sqEntries = params.sq_entries;
+
+    char *cq = static_cast<char *>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // 注册一张空的固定文件表，openat 直接把文件装进指定的槽
+    QVector<int> files(m_slots.size(), -1);
+    return ioUringRegister(m_ringFd, IORING_REGISTER_FILES, files.constData(), unsigned(files.size())) == 0;
+}
+
+bool IoUringWriteBackend::probe()
+{
+    // 旧内核不认识 openat/close 的 file_index 字段，会返回 -EINVAL
+    Slot &slot = m_slots[0];
+    slot.path = QByteArrayLiteral(".");
+
+    io_uring_sqe *openSqe = nextSqe(0, 0);
+    openSqe->opcode = IORING_OP_OPENAT;
+    openSqe->fd = AT_FDCWD;
+    openSqe->addr = quint64(quintptr(slot.path.constData()));
+    openSqe->open_flags = O_RDONLY | O_DIRECTORY;
+    openSqe->file_index = 1;
+    openSqe->flags |= IOSQE_IO_HARDLINK;
+
+    io_uring_sqe *closeSqe = nextSqe(0, 0);
+    closeSqe->opcode = IORING_OP_CLOSE;
+    closeSqe->file_index = 1;
+
+    bool ok = submitAndWait() && !m_failed;
+    m_failed = false;
+    slot.failed = false;
+    slot.path.clear();
+    return ok;
+}
+
+io_uring_sqe *IoUringWriteBackend::nextSqe(int slot, quint64 expected)
+{
+    // 提交队列已满：先提交并等待完成，之前的操作都已结束，不需要再链接
+    if (m_toSubmit >= m_sqEntries && !submitAndWait()) {
+        return nullptr;
+    }
+
+    // 只有内核在 io_uring_enter 中读取提交队列，这里可以直接更新队尾
+    unsigned tail = *m_sqTail;
+    unsigned index = tail & *m_sqMask;
+    io_uring_sqe *sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = userData(slot, quint32(expected));
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+    return sqe;
+}
+
+bool IoUringWriteBackend::submitAndWait()
+{
+    while (m_toSubmit > 0 || m_inFlight > 0) {
+        int ret = ioUringEnter(m_ringFd, m_toSubmit, m_toSubmit + m_inFlight, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                reapCompletions();
+                continue;
+            }
+            m_failed = true;
+            return false;
+        }
+        m_toSubmit -= unsigned(ret);
+        m_inFlight += unsigned(ret);
+        reapCompletions();
+    }
+
+    m_linkTail = nullptr;
+    return true;
+}
+
+void IoUringWriteBackend::reapCompletions()
+{
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe *cqe = &m_cqes[head & *m_cqMask];
+        int slot = int(cqe->user_data >> 32) - 1;
+        quint32 expected = quint32(cqe->user_data);
+        bool ok = expected == IGNORE_RESULT || (expected == 0 ? cqe->res >= 0 : cqe->res == qint64(expected));
+        if (!ok) {
+            m_failed = true;
+            if (slot >= 0 && slot < m_slots.size()) {
+                m_slots[slot].failed = true;
+            }
+        }
+        head++;
+        m_inFlight--;
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+}
+
+bool IoUringWriteBackend::begin(const QString &path, qint64 fileOffset, qint64 fileSize)
+{
+    if (m_currentSlot >= 0) {
+        return false;
+    }
+
+    int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % m_slots.size();
+    encodePath(path, m_slots[slot].path);
+    m_slots[slot].failed = false;
+
+    // 新建前先删除已有的文件（可能与其他文件硬链接），文件不存在时失败，结果不检查
+    io_uring_sqe *unlink = nullptr;
+    if (fileOffset < 0) {
+        unlink = nextSqe(slot, IGNORE_RESULT);
+        if (!unlink) {
+            return false;
+        }
+        unlink->opcode = IORING_OP_UNLINKAT;
+        unlink->fd = AT_FDCWD;
+        unlink->addr = quint64(quintptr(m_slots[slot].path.constData()));
+        m_linkTail = unlink;
+    }
+
+    // 分段写入的文件已经按最终大小创建好，不能截断；
+    // 固定文件槽不会被子进程继承，内核也不接受 O_CLOEXEC
+    io_uring_sqe *sqe = nextSqe(slot, 0);
+    if (!sqe) {
+        return false;
+    }
+    if (unlink && m_linkTail) {
+        unlink->flags |= IOSQE_IO_HARDLINK;
+    }
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = quint64(quintptr(m_slots[slot].path.constData()));
+    sqe->open_flags = fileOffset < 0 ? O_WRONLY | O_CREAT | O_TRUNC : O_WRONLY;
+    sqe->len = FILE_MODE;
+    sqe->file_index = unsigned(slot + 1);
+
+    m_linkTail = sqe;
+    m_currentSlot = slot;
+    m_position = qMax<qint64>(0, fileOffset);
+
+    // 大文件按最终大小预分配，文件系统不支持时忽略（HARDLINK 保证后续写入照常执行）
+    if (fileOffset < 0 && fileSize >= PREALLOCATE_THRESHOLD) {
+        io_uring_sqe *previous = m_linkTail;
+        io_uring_sqe *fallocate = nextSqe(slot, IGNORE_RESULT);
+        if (!fallocate) {
+            return false;
+        }
+        if (previous && m_linkTail) {
+            previous->flags |= IOSQE_IO_HARDLINK;
+        }
+        fallocate->opcode = IORING_OP_FALLOCATE;
+        fallocate->flags |= IOSQE_FIXED_FILE;
+        fallocate->fd = slot;
+        fallocate->off = 0;
+        fallocate->addr = quint64(fileSize);
+        fallocate->len = 0;
+        m_linkTail = fallocate;
+    }
+    return true;
+}
+
+bool IoUringWriteBackend::write(const char *data, qint64 size)
+{
+    if (m_currentSlot < 0) {
+        return false;
+    }
+    if (size <= 0) {
+        return true;
+    }
+
+    io_uring_sqe *previous = m_linkTail;
+    io_uring_sqe *sqe = nextSqe(m_currentSlot, quint64(size));
+    if (!sqe) {
+        return false;
+    }
+    // nextSqe 可能因为队列满而先提交了之前的操作，这时不需要链接
+    if (previous && m_linkTail) {
+        previous->flags |= IOSQE_IO_HARDLINK;
+    }
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->flags |= IOSQE_FIXED_FILE;
+    sqe->fd = m_currentSlot;
+    sqe->addr = quint64(quintptr(data));
+    sqe->len = unsigned(size);
+    sqe->off = quint64(m_position);
+
+    m_linkTail = sqe;
+    m_position += size;
+    return true;
+}
+
+bool IoUringWriteBackend::end()
+{
+    if (m_currentSlot < 0) {
+        return false;
+    }
+
+    io_uring_sqe *previous = m_linkTail;
+    io_uring_sqe *sqe = nextSqe(m_currentSlot, 0);
+    if (!sqe) {
+        return false;
+    }
+    // 使用 HARDLINK：前面的写入失败时 close 仍然执行，槽可以继续使用
+    if (previous && m_linkTail) {
+        previous->flags |= IOSQE_IO_HARDLINK;
+    }
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = unsigned(m_currentSlot + 1);
+
+    m_linkTail = nullptr;
+    m_currentSlot = -1;
+    return true;
+}
+
+void IoUringWriteBackend::discard()
+{
+    if (m_currentSlot < 0) {
+        return;
+    }
+    m_slots[m_currentSlot].failed = true;
+    end();
+    submitAndWait();
+    removeFailedFiles();
+    m_failed = false;
+}
+
+bool IoUringWriteBackend::complete()
+{
+    bool ok = submitAndWait() && !m_failed;
+    removeFailedFiles();
+    m_failed = false;
+    return ok;
+}
+
+void IoUringWriteBackend::removeFailedFiles()
+{
+    for (Slot &slot : m_slots) {
+        if (slot.failed && !slot.path.isEmpty()) {
+            ::unlink(slot.path.constData());
+        }
+        slot.failed = false;
+    }
+}
+
+int IoUringWriteBackend::maxPendingBuffers() const
+{
+    return m_maxPendingBuffers;
+}
+
+FileWriteBackend::Kind IoUringWriteBackend::kind() const
+{
+    return IoUring;
+}
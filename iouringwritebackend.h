@@ -0,0 +1,77 @@
+#ifndef IOURINGWRITEBACKEND_H
+#define IOURINGWRITEBACKEND_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "filewritebackend.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Linux io_uring 写入后端：每个文件的 openat、各块 write 和 close 链接成一串，
+// 使用固定文件槽（direct descriptor）传递文件描述符，不需要等 openat 返回，
+// 大文件在 openat 之后链接一个 fallocate 预分配空间；
+// 多个文件的操作攒到 complete() 时用一次 io_uring_enter 提交并等待完成。
+// 需要 Linux 5.15 以上（openat/close 的 direct descriptor），否则 isReady() 返回 false
+class IoUringWriteBackend : public FileWriteBackend
+{
+public:
+    explicit IoUringWriteBackend(int maxPendingBuffers);
+    ~IoUringWriteBackend() override;
+
+    bool isReady() const;
+
+    bool begin(const QString &path, qint64 fileOffset, qint64 fileSize) override;
+    bool write(const char *data, qint64 size) override;
+    bool end() override;
+    void discard() override;
+    bool complete() override;
+    int maxPendingBuffers() const override;
+    Kind kind() const override;
+
+private:
+    struct Slot {
+        QByteArray path;    // openat 提交前必须保持有效
+        bool failed;
+    };
+
+    bool setup(unsigned entries);
+    bool probe();
+    io_uring_sqe *nextSqe(int slot, quint64 expected);
+    bool submitAndWait();
+    void reapCompletions();
+    void removeFailedFiles();
+
+    int m_ringFd;
+    int m_maxPendingBuffers;
+
+    // 映射的提交队列、完成队列和 SQE 数组
+    void *m_sqRing;
+    void *m_cqRing;
+    size_t m_sqRingSize;
+    size_t m_cqRingSize;
+    io_uring_sqe *m_sqes;
+    size_t m_sqesSize;
+    unsigned *m_sqHead;
+    unsigned *m_sqTail;
+    unsigned *m_sqMask;
+    unsigned *m_sqArray;
+    unsigned m_sqEntries;
+    unsigned *m_cqHead;
+    unsigned *m_cqTail;
+    unsigned *m_cqMask;
+    io_uring_cqe *m_cqes;
+
+    unsigned m_toSubmit;        // 已填好还没提交的 SQE
+    unsigned m_inFlight;        // 已提交还没完成的 SQE
+    io_uring_sqe *m_linkTail;   // 当前文件最后一个未提交的 SQE，后续操作要链接在它之后
+
+    QVector<Slot> m_slots;      // 固定文件槽
+    int m_nextSlot;
+    int m_currentSlot;          // 正在写的文件所在的槽，没有时为 -1
+    qint64 m_position;
+    bool m_failed;
+};
+
+#endif // IOURINGWRITEBACKEND_H
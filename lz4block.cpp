@@ -0,0 +1,103 @@
+#include "lz4block.h"
+
+#include <cstring>
+
+namespace {
+
+// 最短匹配长度，以及为批量复制预留的余量
+const int MIN_MATCH = 4;
+const int WILD_COPY = 8;
+
+inline void copy8(uchar *dst, const uchar *src)
+{
+    memcpy(dst, src, 8);
+}
+
+// 读取扩展长度：每个 255 字节继续累加，直到遇到小于 255 的字节
+inline bool readLength(const uchar *&ip, const uchar *end, qint64 &length)
+{
+    uchar byte;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+qint64 Lz4Block::decompress(const uchar *src, qint64 srcSize, uchar *dst, qint64 dstCapacity)
+{
+    const uchar *ip = src;
+    const uchar *const inEnd = src + srcSize;
+    uchar *op = dst;
+    uchar *const outEnd = dst + dstCapacity;
+
+    while (ip < inEnd) {
+        const uchar token = *ip++;
+
+        // 字面量
+        qint64 literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, inEnd, literalLength)) {
+            return -1;
+        }
+        if (literalLength > inEnd - ip || literalLength > outEnd - op) {
+            return -1;
+        }
+        if (literalLength <= 16 && inEnd - ip >= 16 && outEnd - op >= 16) {
+            copy8(op, ip);
+            copy8(op + 8, ip + 8);
+        } else {
+            memcpy(op, ip, size_t(literalLength));
+        }
+        ip += literalLength;
+        op += literalLength;
+
+        // 最后一个序列只有字面量
+        if (ip == inEnd) {
+            break;
+        }
+
+        // 匹配：2 字节小端偏移 + 长度
+        if (inEnd - ip < 2) {
+            return -1;
+        }
+        const qint64 offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+
+        qint64 matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, inEnd, matchLength)) {
+            return -1;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > outEnd - op) {
+            return -1;
+        }
+
+        const uchar *match = op - offset;
+        if (offset >= WILD_COPY && outEnd - op >= matchLength + WILD_COPY) {
+            // 不重叠时按 8 字节批量复制，可能多写几个字节，之后会被覆盖
+            uchar *copyEnd = op + matchLength;
+            while (op < copyEnd) {
+                copy8(op, match);
+                op += 8;
+                match += 8;
+            }
+            op = copyEnd;
+        } else {
+            // 重叠复制（例如游程）必须逐字节进行
+            for (qint64 i = 0; i < matchLength; i++) {
+                op[i] = match[i];
+            }
+            op += matchLength;
+        }
+    }
+
+    return op - dst;
+}
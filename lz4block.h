@@ -0,0 +1,14 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <QtGlobal>
+
+// LZ4 块格式解码（不含帧头），分帧安装包中每一帧都是一个独立的 LZ4 块
+class Lz4Block
+{
+public:
+    // 解码 src 到 dst，返回解码出的字节数；数据损坏或超出 dstCapacity 时返回 -1
+    static qint64 decompress(const uchar *src, qint64 srcSize, uchar *dst, qint64 dstCapacity);
+};
+
+#endif // LZ4BLOCK_H
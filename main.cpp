@@ -2,12 +2,18 @@
 
 #include <QLoggingCategory>
 
-#include <io.h>
-#include <fcntl.h>
 #include <QStyleFactory>
 #include <QDir>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QScopedPointer>
 
+#include <cstdio>
+
+#include "entrystreamer.h"
 #include "mainwindow.h"
+#include "memorybudget.h"
+#include "silentinstaller.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -18,15 +24,75 @@
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // 启动计时，界面模式下第一帧画出后报告
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    
+    // 静默安装只创建 QCoreApplication，不加载界面和平台插件，也不需要显示环境
+    bool silent = false;
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], "--silent") == 0) {
+            silent = true;
+        }
+    }
+    QScopedPointer<QCoreApplication> app(silent ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    if (silent) {
+        SilentInstaller::attachConsole();
+    }
 
     // 设置应用程序信息
-    app.setApplicationName("Ausic Installer");
-    app.setApplicationVersion("1.0.0");
-    app.setOrganizationName("Ausic");
+    app->setApplicationName("Ausic Installer");
+    app->setApplicationVersion("1.0.0");
+    app->setOrganizationName("Ausic");
+    
+    // 命令行参数
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption threadsOption("threads", "解压线程数，默认按 CPU 核数自动选择", "count");
+    parser.addOption(threadsOption);
+    QCommandLineOption noDedupOption("no-dedup", "不合并内容相同的文件，每个文件都单独解压");
+    parser.addOption(noDedupOption);
+    QCommandLineOption hardlinkOption("hardlink-duplicates", "内容相同的文件使用硬链接");
+    parser.addOption(hardlinkOption);
+    QCommandLineOption writeBackendOption("write-backend", "写盘方式：portable 或 io_uring（仅 Linux）", "backend", "portable");
+    parser.addOption(writeBackendOption);
+    QCommandLineOption silentOption("silent", "静默安装：不显示界面，进度以 JSON 行输出到标准输出");
+    parser.addOption(silentOption);
+    QCommandLineOption targetOption("target", "安装目录（静默安装时必须指定）", "dir");
+    parser.addOption(targetOption);
+    QCommandLineOption maxMemoryOption("max-memory", "校验和解压缓冲的内存上限，例如 256M；超出时缩小缓冲、减少解压线程", "size", "0");
+    parser.addOption(maxMemoryOption);
+    QCommandLineOption traceOption("trace", "记录安装过程的时间线（Chrome / Perfetto trace event 格式）", "file");
+    parser.addOption(traceOption);
+    parser.process(*app);
+    
+    InstallOptions options;
+    options.threadCount = parser.value(threadsOption).toInt();
+    options.deduplicate = !parser.isSet(noDedupOption);
+    options.hardlinkDuplicates = parser.isSet(hardlinkOption);
+    options.tracePath = parser.value(traceOption);
+    if (!FileWriteBackend::parseKind(parser.value(writeBackendOption), options.writeBackend)
+        || !MemoryBudget::parseSize(parser.value(maxMemoryOption), options.maxMemory)) {
+        parser.showHelp(SilentInstaller::UsageError);
+    }
+    qint64 minimumMemory = MemoryBudget::minimumBytes(sizeof(EntryStreamer));
+    if (options.maxMemory > 0 && options.maxMemory < minimumMemory) {
+        fprintf(stderr, "--max-memory 至少为 %lldK\n", (minimumMemory + 1023) / 1024);
+        return SilentInstaller::UsageError;
+    }
+    
+    if (silent) {
+        if (!parser.isSet(targetOption)) {
+            fprintf(stderr, "--silent 需要用 --target 指定安装目录\n");
+            return SilentInstaller::UsageError;
+        }
+        SilentInstaller installer(options, parser.value(targetOption));
+        installer.start();
+        return app->exec();
+    }
     
     // 设置现代化样式
-    app.setStyle(QStyleFactory::create("Fusion"));
+    QApplication::setStyle(QStyleFactory::create("Fusion"));
     
     // 设置深色主题
     QPalette darkPalette;
@@ -43,14 +109,15 @@ int main(int argc, char *argv[])
     darkPalette.setColor(QPalette::Link, QColor(42, 130, 218));
     darkPalette.setColor(QPalette::Highlight, QColor(42, 130, 218));
     darkPalette.setColor(QPalette::HighlightedText, Qt::black);
-    app.setPalette(darkPalette);
+    QApplication::setPalette(darkPalette);
     
-    MainWindow window;
+    MainWindow window(options);
+    window.setStartupTimer(startupTimer);
     window.show();
     
 
     
-    int result = app.exec();
+    int result = app->exec();
     
 
     
@@ -14,25 +14,45 @@
 #include <QTimer>
 #include <QDir>
 #include <QFileInfo>
+#include <QScreen>
+#include <QPixmapCache>
 
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(const InstallOptions &options, QWidget *parent)
     : QMainWindow(parent)
     , m_centralWidget(nullptr)
     , m_mainLayout(nullptr)
+    , m_installPage(nullptr)
+    , m_finishPage(nullptr)
     , m_installer(nullptr)
+    , m_installerThread(nullptr)
     , m_loadingMovie(nullptr)
-    , m_isUpgradeMode(false)
+    , m_firstFrameShown(false)
 {
     setupUI();
     
-    // 创建安装器实例
-    m_installer = new Installer(this);
+    // 创建安装器实例，并放到独立的工作线程中运行，界面线程不再被安装过程阻塞
+    m_installerThread = new QThread(this);
+    m_installer = new Installer();
+    // 进度上报间隔跟随屏幕刷新率，更频繁的信号只会被界面丢弃
+    InstallOptions installOptions = options;
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        if (screen->refreshRate() > 0) {
+            installOptions.progressIntervalMs = qMax(1, qRound(1000.0 / screen->refreshRate()));
+        }
+    }
+    m_installer->setOptions(installOptions);
+    m_installer->moveToThread(m_installerThread);
+    connect(m_installerThread, &QThread::finished, m_installer, &QObject::deleteLater);
+    m_installerThread->start();
     
-    // 连接信号
-    connect(m_installer, &Installer::progressUpdated, this, &MainWindow::onInstallationProgress);
-    connect(m_installer, &Installer::installationFinished, this, &MainWindow::onInstallationFinished);
-    connect(m_installer, &Installer::errorOccurred, this, &MainWindow::onInstallationError);
+    // 连接信号（跨线程，排队传递）
+    connect(m_installer, &Installer::progressUpdated, this, &MainWindow::onInstallationProgress, Qt::QueuedConnection);
+    connect(m_installer, &Installer::installationFinished, this, &MainWindow::onInstallationFinished, Qt::QueuedConnection);
+    connect(m_installer, &Installer::errorOccurred, this, &MainWindow::onInstallationError, Qt::QueuedConnection);
+    
+    // 上次安装被中断时遗留的旧文件，启动后就在后台删除
+    m_installer->sweepTrash();
     
     // 显示欢迎页面
     showWelcomePage();
@@ -40,6 +60,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 等待安装线程退出，安装器随线程结束一起释放（会等后台删除旧文件完成）
+    m_installerThread->quit();
+    m_installerThread->wait();
+    
     if (m_loadingMovie) {
         delete m_loadingMovie;
     }
@@ -100,10 +124,56 @@ void MainWindow::setupUI()
     m_mainLayout = new QVBoxLayout(m_centralWidget);
     m_mainLayout->setContentsMargins(0, 0, 0, 0);
     
-    // 设置页面
+    // 启动时只创建欢迎页，安装页和完成页在第一次显示时才创建
     setupWelcomePage();
-    setupInstallPage();
-    setupFinishPage();
+}
+
+void MainWindow::setStartupTimer(const QElapsedTimer &timer)
+{
+    m_startupTimer = timer;
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    if (m_firstFrameShown) {
+        return;
+    }
+    m_firstFrameShown = true;
+    
+    // 等这一帧送到屏幕上之后再计时，并开始不影响首屏的工作
+    QTimer::singleShot(0, this, &MainWindow::onFirstFrame);
+}
+
+void MainWindow::onFirstFrame()
+{
+    if (m_startupTimer.isValid()) {
+        qInfo("首帧耗时 %lld ms", m_startupTimer.elapsed());
+    }
+}
+
+QPixmap MainWindow::iconPixmap(const QString &name) const
+{
+    // 资源中的图标已经按显示尺寸缩放好（1 倍和 @2x 两种，见 scale_icons.py），按屏幕缩放比例选一种；
+    // 其他缩放比例下才需要缩放，结果放进缓存，同一个图标只缩放一次
+    qreal ratio = devicePixelRatioF();
+    int pixels = qRound(ICON_SIZE * ratio);
+    QString key = QStringLiteral("icon:%1@%2").arg(name).arg(pixels);
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+    
+    QString file = ratio > 1.0 ? QStringLiteral(":/images/icons/%1@2x.png") : QStringLiteral(":/images/icons/%1.png");
+    if (!pixmap.load(file.arg(name))) {
+        return QPixmap();
+    }
+    if (pixmap.width() != pixels) {
+        pixmap = pixmap.scaled(pixels, pixels, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    pixmap.setDevicePixelRatio(ratio);
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
 }
 
 void MainWindow::setupWelcomePage()
@@ -131,9 +201,9 @@ void MainWindow::setupWelcomePage()
     m_welcomeIcon = new QLabel();
     m_welcomeIcon->setAlignment(Qt::AlignCenter);
     m_welcomeIcon->setFixedSize(100, 100);
-    QPixmap welcomePixmap(":/images/welcome.png");
+    QPixmap welcomePixmap = iconPixmap("welcome");
     if (!welcomePixmap.isNull()) {
-        m_welcomeIcon->setPixmap(welcomePixmap.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        m_welcomeIcon->setPixmap(welcomePixmap);
     } else {
         m_welcomeIcon->setText("♪");
         m_welcomeIcon->setStyleSheet(
@@ -259,15 +329,8 @@ void MainWindow::setupWelcomePage()
      
     buttonLayout->addWidget(m_installButton);
     
-    // 检测是否已安装
-    QString defaultPath = m_installPathEdit->text();
-    m_isUpgradeMode = checkExistingInstallation(defaultPath);
-    
     // 连接信号
     connect(m_installButton, &QPushButton::clicked, this, &MainWindow::startInstallation);
-    connect(m_installPathEdit, &QLineEdit::textChanged, [this](const QString &text) {
-        m_isUpgradeMode = checkExistingInstallation(text);
-    });
     
     layout->addLayout(iconLayout);
     layout->addWidget(m_welcomeTitle);
@@ -296,9 +359,9 @@ void MainWindow::setupInstallPage()
     m_installIcon = new QLabel();
     m_installIcon->setAlignment(Qt::AlignCenter);
     m_installIcon->setFixedSize(100, 100);
-    QPixmap installPixmap(":/images/installing.png");
+    QPixmap installPixmap = iconPixmap("installing");
     if (!installPixmap.isNull()) {
-        m_installIcon->setPixmap(installPixmap.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        m_installIcon->setPixmap(installPixmap);
     } else {
         m_installIcon->setText("♪");
         m_installIcon->setStyleSheet(
@@ -471,6 +534,10 @@ void MainWindow::showWelcomePage()
 
 void MainWindow::showInstallPage()
 {
+    if (!m_installPage) {
+        setupInstallPage();
+    }
+    
     // 清除当前布局
     QLayoutItem *item;
     while ((item = m_mainLayout->takeAt(0)) != nullptr) {
@@ -485,6 +552,10 @@ void MainWindow::showInstallPage()
 
 void MainWindow::showFinishPage(bool success)
 {
+    if (!m_finishPage) {
+        setupFinishPage();
+    }
+    
     // 清除当前布局
     QLayoutItem *item;
     while ((item = m_mainLayout->takeAt(0)) != nullptr) {
@@ -496,9 +567,9 @@ void MainWindow::showFinishPage(bool success)
     
     // 设置完成页面内容
     if (success) {
-        QPixmap successPixmap(":/images/success.png");
+        QPixmap successPixmap = iconPixmap("success");
         if (!successPixmap.isNull()) {
-            m_finishIcon->setPixmap(successPixmap.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+            m_finishIcon->setPixmap(successPixmap);
         } else {
             m_finishIcon->setText("✓");
         }
@@ -542,16 +613,9 @@ void MainWindow::startInstallation()
 {
     showInstallPage();
     
-    // 延迟启动安装，让界面有时间更新
-    QTimer::singleShot(100, [this]() {
-        QString installPath = m_installPathEdit->text();
-        
-        // 删除目标文件夹中的旧程序文件
-        deleteOldInstallation(installPath);
-    
-    m_installer->setInstallPath(installPath);
-        m_installer->startInstallation();
-    });
+    // 旧程序文件的删除也在安装线程中进行，界面无需等待
+    m_installer->setInstallPath(m_installPathEdit->text());
+    m_installer->startInstallation();
 }
 
 void MainWindow::onInstallationProgress(int percentage, const QString &message)
@@ -567,10 +631,7 @@ void MainWindow::onInstallationFinished(bool success, const QString &message)
         createDesktopShortcut(m_installer->getInstallDirectory());
     }
     
-    // 延迟显示完成页面
-    QTimer::singleShot(1000, [this, success]() {
-        showFinishPage(success);
-    });
+    showFinishPage(success);
 }
 
 void MainWindow::onInstallationError(const QString &error)
@@ -582,9 +643,7 @@ void MainWindow::onInstallationError(const QString &error)
     QMessageBox::critical(this, "安装错误", error);
     
     // 显示失败页面
-    QTimer::singleShot(1000, [this]() {
-        showFinishPage(false);
-    });
+    showFinishPage(false);
 }
 
 void MainWindow::browseInstallPath()
@@ -606,48 +665,6 @@ void MainWindow::browseInstallPath()
     }
 }
 
-bool MainWindow::checkExistingInstallation(const QString &path)
-{
-    QDir installDir(path);
-    if (!installDir.exists()) {
-        return false;
-    }
-    
-    // 检查是否存在 Ausic.exe 或其他标识文件
-    QFileInfo exeFile(installDir.absoluteFilePath("Ausic.exe"));
-    return exeFile.exists();
-}
-
-void MainWindow::deleteOldInstallation(const QString &path)
-{
-    QDir installDir(path);
-    if (!installDir.exists()) {
-        return;
-    }
-    
-    try {
-        // 删除目录中的所有文件和子目录
-        QStringList entries = installDir.entryList(QDir::NoDotAndDotDot | QDir::AllEntries);
-        for (const QString &entry : entries) {
-            QString fullPath = installDir.absoluteFilePath(entry);
-            QFileInfo fileInfo(fullPath);
-            
-            if (fileInfo.isDir()) {
-                QDir subDir(fullPath);
-                if (!subDir.removeRecursively()) {
-        
-                }
-            } else {
-                if (!QFile::remove(fullPath)) {
-    
-                }
-            }
-        }
-    } catch (...) {
-        QMessageBox::warning(this, "升级提示", "删除旧文件时遇到问题，但升级将继续进行。");
-    }
-}
-
 void MainWindow::createDesktopShortcut(const QString &installPath)
 {
     QString desktopPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
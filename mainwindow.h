@@ -15,6 +15,7 @@
 #include <QCheckBox>
 #include <QStandardPaths>
 #include <QProcess>
+#include <QElapsedTimer>
 #include "installer.h"
 
 QT_BEGIN_NAMESPACE
@@ -31,15 +32,22 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    MainWindow(const InstallOptions &options = InstallOptions(), QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 从进程启动开始计时，第一帧画出后报告启动耗时
+    void setStartupTimer(const QElapsedTimer &timer);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
 private slots:
     void startInstallation();
     void onInstallationProgress(int percentage, const QString &message);
     void onInstallationFinished(bool success, const QString &message);
     void onInstallationError(const QString &error);
     void browseInstallPath();
+    void onFirstFrame();
 
 private:
     void setupUI();
@@ -49,10 +57,9 @@ private:
     void showWelcomePage();
     void showInstallPage();
     void showFinishPage(bool success);
-    bool checkExistingInstallation(const QString &path);
-    void deleteOldInstallation(const QString &path);
     void createDesktopShortcut(const QString &installPath);
     void launchApplication(const QString &installPath);
+    QPixmap iconPixmap(const QString &name) const;
     
     // UI组件
     QWidget *m_centralWidget;
@@ -82,14 +89,19 @@ private:
     QCheckBox *m_launchCheckBox;
     QPushButton *m_finishButton;
     
-    // 安装器
+    // 安装器（运行在独立的工作线程中）
     Installer *m_installer;
+    QThread *m_installerThread;
     
     // 动画
     QMovie *m_loadingMovie;
     
-    // 升级模式
-    bool m_isUpgradeMode;
+    // 启动计时
+    QElapsedTimer m_startupTimer;
+    bool m_firstFrameShown;
+    
+    // 图标的显示尺寸（逻辑像素）
+    static const int ICON_SIZE = 100;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
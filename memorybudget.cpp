@@ -0,0 +1,114 @@
+#include "memorybudget.h"
+
+#include <limits>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+qint64 pageSize()
+{
+    static const qint64 size = []() {
+#if defined(Q_OS_WIN)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return qint64(info.dwPageSize);
+#else
+        return qint64(sysconf(_SC_PAGESIZE));
+#endif
+    }();
+    return size;
+}
+
+} // namespace
+
+MemoryBudget::Plan MemoryBudget::plan(qint64 budget, int threads, int bufferCount, int bufferSize,
+                                      int minBufferSize, qint64 workerOverhead)
+{
+    threads = qMax(1, threads);
+    Plan result = { threads, bufferCount, bufferSize,
+                    threads * workerBytes(bufferCount, bufferSize, workerOverhead) };
+    if (budget <= 0 || result.bytes <= budget) {
+        return result;
+    }
+
+    // 先减少缓冲块数，再缩小缓冲块，直到请求的线程数都放得下；
+    // 缩到最小仍然放不下时，按上限能容纳的线程数运行
+    int minCount = qMin(bufferCount, int(MIN_BUFFER_COUNT));
+    int minSize = qMin(bufferSize, qMax(int(MIN_BUFFER_SIZE), minBufferSize));
+    int count = bufferCount;
+    int size = bufferSize;
+    forever {
+        qint64 perWorker = workerBytes(count, size, workerOverhead);
+        int workers = int(qMin<qint64>(threads, budget / perWorker));
+        if (workers == threads || (count == minCount && size == minSize)) {
+            result.workers = workers;
+            result.bufferCount = count;
+            result.bufferSize = size;
+            result.bytes = qMax(1, workers) * perWorker;
+            return result;
+        }
+        if (count > minCount) {
+            count = qMax(minCount, count / 2);
+        } else {
+            size = qMax(minSize, size / 2);
+        }
+    }
+}
+
+qint64 MemoryBudget::workerBytes(int bufferCount, int bufferSize, qint64 workerOverhead)
+{
+    return qint64(bufferCount + 1) * bufferSize + RELEASE_STEP + workerOverhead;
+}
+
+qint64 MemoryBudget::minimumBytes(qint64 workerOverhead)
+{
+    return workerBytes(MIN_BUFFER_COUNT, MIN_BUFFER_SIZE, workerOverhead);
+}
+
+bool MemoryBudget::parseSize(const QString &text, qint64 &bytes)
+{
+    QString value = text.trimmed().toUpper();
+    if (value.endsWith(QLatin1String("IB"))) {
+        value.chop(2);
+    } else if (value.endsWith(QLatin1Char('B'))) {
+        value.chop(1);
+    }
+
+    int shift = 0;
+    static const QString units = QStringLiteral("KMGT");
+    if (!value.isEmpty() && units.contains(value.back())) {
+        shift = 10 * (units.indexOf(value.back()) + 1);
+        value.chop(1);
+    }
+
+    bool ok = false;
+    qint64 number = value.toLongLong(&ok);
+    if (!ok || number < 0 || number > (std::numeric_limits<qint64>::max() >> shift)) {
+        return false;
+    }
+    bytes = number << shift;
+    return true;
+}
+
+void MemoryBudget::releasePages(const uchar *address, qint64 size)
+{
+    quintptr mask = quintptr(pageSize() - 1);
+    quintptr begin = quintptr(address) & ~mask;
+    quintptr end = (quintptr(address) + quintptr(size)) & ~mask;
+    if (end <= begin) {
+        return;
+    }
+
+#if defined(Q_OS_WIN)
+    // 对没有锁定的页调用 VirtualUnlock 会把它们移出工作集，返回值总是失败，不需要检查
+    VirtualUnlock(reinterpret_cast<void *>(begin), SIZE_T(end - begin));
+#else
+    ::madvise(reinterpret_cast<void *>(begin), size_t(end - begin), MADV_DONTNEED);
+#endif
+}
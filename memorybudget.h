@@ -0,0 +1,47 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QString>
+#include <QtGlobal>
+
+// 解压阶段的内存上限（--max-memory）。内存占用来自每个工作线程的解压/写盘缓冲环、
+// 解码器状态和映射进来的压缩数据，与条目大小无关（条目都是流式解压的，大文件按帧分段），
+// 因此按上限选择工作线程数和缓冲块的数量、大小：先缩小缓冲，尽量保留并行度，放不下时再减少线程
+class MemoryBudget
+{
+public:
+    struct Plan {
+        int workers;
+        int bufferCount;
+        int bufferSize;
+        qint64 bytes;   // 按这个方案预计的峰值占用
+    };
+
+    // budget 为 0 时不限制，直接使用请求的线程数和缓冲；
+    // minBufferSize 是缓冲块允许的最小值（分帧载荷为帧大小），workerOverhead 是每个线程的固定开销。
+    // 一个线程、最小的缓冲也超过上限时不运行：workers 为 0，bytes 为至少需要的内存
+    static Plan plan(qint64 budget, int threads, int bufferCount, int bufferSize, int minBufferSize,
+                     qint64 workerOverhead);
+
+    // 每个线程的占用：缓冲块，加上最多 RELEASE_STEP 和一块的已映射输入，加上固定开销
+    static qint64 workerBytes(int bufferCount, int bufferSize, qint64 workerOverhead);
+
+    // 与载荷无关的最低上限：一个线程，MIN_BUFFER_COUNT 块 MIN_BUFFER_SIZE 的缓冲。
+    // 分帧载荷的帧比 MIN_BUFFER_SIZE 大时实际需要更多，由 plan() 检查
+    static qint64 minimumBytes(qint64 workerOverhead);
+
+    // "256M"、"1G"、"512K" 或字节数，单位按 1024 计，可以带 B / iB 后缀
+    static bool parseSize(const QString &text, qint64 &bytes);
+
+    // 把只读文件映射中已经读过的区间移出进程的工作集（数据仍在页缓存中）。
+    // 起点和终点都向下对齐到页边界，误释放的页再次访问时会从页缓存重新映射
+    static void releasePages(const uchar *address, qint64 size);
+
+    static const int MIN_BUFFER_COUNT = 2;
+    static const int MIN_BUFFER_SIZE = 64 * 1024;
+
+    // 顺序读取映射数据时，每读过这么多字节释放一次
+    static const qint64 RELEASE_STEP = 1024 * 1024;
+};
+
+#endif // MEMORYBUDGET_H
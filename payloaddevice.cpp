@@ -0,0 +1,129 @@
+#include "payloaddevice.h"
+
+#include <QMutexLocker>
+
+#include <cstring>
+
+PayloadDevice::PayloadDevice(const QString &filePath, qint64 offset, qint64 size, QObject *parent)
+    : QIODevice(parent)
+    , m_file(filePath)
+    , m_offset(offset)
+    , m_size(size)
+    , m_map(nullptr)
+{
+}
+
+PayloadDevice::~PayloadDevice()
+{
+    close();
+
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+bool PayloadDevice::open(OpenMode mode)
+{
+    // 只允许只读访问
+    if (mode & QIODevice::WriteOnly) {
+        return false;
+    }
+
+    if (m_offset < 0 || m_size <= 0) {
+        return false;
+    }
+
+    // ZipIndex 读完目录后设备可能被关闭，解压前再重新打开（extractArchiveToDirectory）；
+    // 解压线程通过 data() / mapRegion() 直接访问映射，因此映射在对象生命周期内保持，重新打开时直接复用
+    if (!m_file.isOpen()) {
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        if (m_offset + m_size > m_file.size()) {
+            m_file.close();
+            return false;
+        }
+
+        // 优先使用内存映射，失败时退回到按需 seek/read
+        m_map = m_file.map(m_offset, m_size);
+    }
+
+    // 不使用 QIODevice 自带的缓冲，避免多一次拷贝
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void PayloadDevice::close()
+{
+    if (isOpen()) {
+        QIODevice::close();
+    }
+}
+
+bool PayloadDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 PayloadDevice::size() const
+{
+    return m_size;
+}
+
+const uchar *PayloadDevice::data() const
+{
+    return m_map;
+}
+
+bool PayloadDevice::isMapped() const
+{
+    return m_map != nullptr;
+}
+
+uchar *PayloadDevice::mapRegion(qint64 offset, qint64 size)
+{
+    if (offset < 0 || size <= 0 || offset + size > m_size || !m_file.isOpen()) {
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_regionMutex);
+    return m_file.map(m_offset + offset, size);
+}
+
+void PayloadDevice::unmapRegion(uchar *address)
+{
+    if (address) {
+        QMutexLocker locker(&m_regionMutex);
+        m_file.unmap(address);
+    }
+}
+
+qint64 PayloadDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 position = pos();
+    qint64 available = m_size - position;
+    if (available <= 0) {
+        return 0;
+    }
+
+    qint64 bytesToRead = qMin(maxSize, available);
+
+    if (m_map) {
+        memcpy(data, m_map + position, size_t(bytesToRead));
+        return bytesToRead;
+    }
+
+    if (!m_file.seek(m_offset + position)) {
+        return -1;
+    }
+    return m_file.read(data, bytesToRead);
+}
+
+qint64 PayloadDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
\ No newline at end of file
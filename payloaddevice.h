@@ -0,0 +1,43 @@
+#ifndef PAYLOADDEVICE_H
+#define PAYLOADDEVICE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QMutex>
+
+// 安装程序自身内嵌压缩包的只读视图
+// 直接映射 exe 中 [offset, offset + size) 区间，不再复制到临时文件
+class PayloadDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    PayloadDevice(const QString &filePath, qint64 offset, qint64 size, QObject *parent = nullptr);
+    ~PayloadDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    qint64 size() const override;
+
+    // 映射成功时返回整个压缩包区间的首地址，否则返回 nullptr
+    const uchar *data() const;
+    bool isMapped() const;
+
+    // 整体映射失败时，按需映射压缩包内的一个区间（偏移相对压缩包起始位置）
+    uchar *mapRegion(qint64 offset, qint64 size);
+    void unmapRegion(uchar *address);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QFile m_file;
+    qint64 m_offset;
+    qint64 m_size;
+    uchar *m_map;
+    QMutex m_regionMutex;   // 多个解压线程可能同时映射各自的区间
+};
+
+#endif // PAYLOADDEVICE_H
\ No newline at end of file
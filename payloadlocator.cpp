@@ -0,0 +1,532 @@
+#include "payloadlocator.h"
+#include "zipindex.h"
+
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PAYLOADLOCATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+const quint32 ZIP64_END_OF_CENTRAL_DIR_SIGNATURE = 0x06064b50;
+const quint32 ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+
+const int LOCAL_HEADER_SIZE = 30;
+const int END_OF_CENTRAL_DIR_SIZE = 22;
+const int ZIP64_END_OF_CENTRAL_DIR_SIZE = 56;
+const int ZIP64_LOCATOR_SIZE = 20;
+const int MAX_COMMENT_SIZE = 65535;
+
+// append_zip.py 写在文件末尾的元数据：魔术字符串 + 偏移 + 大小 + 元数据长度，
+// 元数据长度大于 TRAILER_SIZE 时，多出的部分是紧跟在 ZIP 数据之后的安装清单
+const char TRAILER_MAGIC[] = "AUSIC_ZIP_INFO";
+const int TRAILER_MAGIC_SIZE = 14;
+const int TRAILER_SIZE = TRAILER_MAGIC_SIZE + 8 + 8 + 4;
+
+// 整体校验值紧挨在末尾元数据之前：魔术字符串 + 叶子大小 + 保留 + 覆盖长度 + 根哈希，
+// 旧版安装程序把它当作清单末尾多余的字节忽略
+const char CHECKSUM_MAGIC[] = "AUSICSUM";
+const int CHECKSUM_MAGIC_SIZE = 8;
+const int CHECKSUM_BLOCK_SIZE = CHECKSUM_MAGIC_SIZE + 4 + 4 + 8 + PayloadChecksum::HASH_SIZE;
+
+// 找不到结束记录对应的文件头时，最多向前扫描的范围
+const qint64 MAX_SCAN_SIZE = 200 * 1024 * 1024LL;
+
+// 无法整体映射时按块读取，相邻块重叠 3 字节以免签名跨块
+const qint64 SCAN_BLOCK_SIZE = 4 * 1024 * 1024;
+
+const int ELF_SECTION_NOBITS = 8;
+
+inline quint16 readU16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+inline quint32 readU32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+inline quint64 readU64(const uchar *p) { return qFromLittleEndian<quint64>(p); }
+
+} // namespace
+
+PayloadLocator::PayloadLocator(const QString &filePath)
+    : m_file(filePath)
+    , m_fileSize(0)
+    , m_map(nullptr)
+{
+}
+
+PayloadLocator::~PayloadLocator()
+{
+    close();
+}
+
+bool PayloadLocator::locate(qint64 &archiveOffset, qint64 &archiveSize)
+{
+    m_manifest.clear();
+    m_checksum = PayloadChecksum();
+    if (!open()) {
+        return false;
+    }
+
+    // 依次尝试：末尾元数据、ZIP 结束记录、从镜像结束位置向后找文件头
+    bool found = locateByTrailer(archiveOffset, archiveSize)
+                 || locateByEndRecord(archiveOffset, archiveSize)
+                 || locateByLocalHeader(archiveOffset, archiveSize);
+
+    close();
+    return found;
+}
+
+QByteArray PayloadLocator::manifest() const
+{
+    return m_manifest;
+}
+
+PayloadChecksum PayloadLocator::checksum() const
+{
+    return m_checksum;
+}
+
+bool PayloadLocator::open()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_fileSize = m_file.size();
+    if (m_fileSize > 0) {
+        m_map = m_file.map(0, m_fileSize);
+    }
+    return true;
+}
+
+void PayloadLocator::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+const uchar *PayloadLocator::view(qint64 offset, qint64 size, QByteArray &storage)
+{
+    if (offset < 0 || size < 0 || offset > m_fileSize || size > m_fileSize - offset) {
+        return nullptr;
+    }
+    if (m_map) {
+        return m_map + offset;
+    }
+
+    if (!m_file.seek(offset)) {
+        return nullptr;
+    }
+    storage = m_file.read(size);
+    if (storage.size() != size) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uchar *>(storage.constData());
+}
+
+qint64 PayloadLocator::findSignature(const uchar *data, qint64 size, quint32 signature)
+{
+    const uchar first = uchar(signature & 0xff);
+    const uchar second = uchar((signature >> 8) & 0xff);
+    qint64 pos = 0;
+
+#ifdef PAYLOADLOCATOR_SSE2
+    // 每次比较 16 个起始位置的前两个字节，命中后再比较完整的 4 字节
+    const __m128i firstByte = _mm_set1_epi8(char(first));
+    const __m128i secondByte = _mm_set1_epi8(char(second));
+    for (; pos + 16 + 3 <= size; pos += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos + 1));
+        quint32 mask = quint32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firstByte),
+                                                               _mm_cmpeq_epi8(b, secondByte))));
+        while (mask) {
+            qint64 candidate = pos + qCountTrailingZeroBits(mask);
+            if (readU32(data + candidate) == signature) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    while (pos + 4 <= size) {
+        const void *hit = memchr(data + pos, first, size_t(size - 3 - pos));
+        if (!hit) {
+            break;
+        }
+        pos = static_cast<const uchar *>(hit) - data;
+        if (data[pos + 1] == second && readU32(data + pos) == signature) {
+            return pos;
+        }
+        pos++;
+    }
+    return -1;
+}
+
+qint64 PayloadLocator::findLastSignature(const uchar *data, qint64 size, quint32 signature)
+{
+    const uchar first = uchar(signature & 0xff);
+    const uchar second = uchar((signature >> 8) & 0xff);
+
+    // end 之前（不含 end）的位置还没有检查
+    qint64 end = size - 3;
+
+#ifdef PAYLOADLOCATOR_SSE2
+    const __m128i firstByte = _mm_set1_epi8(char(first));
+    const __m128i secondByte = _mm_set1_epi8(char(second));
+    for (; end >= 16; end -= 16) {
+        const uchar *block = data + end - 16;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 1));
+        quint32 mask = quint32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firstByte),
+                                                               _mm_cmpeq_epi8(b, secondByte))));
+        while (mask) {
+            int bit = 31 - int(qCountLeadingZeroBits(mask));
+            if (readU32(block + bit) == signature) {
+                return end - 16 + bit;
+            }
+            mask &= ~(1u << bit);
+        }
+    }
+#endif
+
+    for (qint64 pos = end - 1; pos >= 0; pos--) {
+        if (data[pos] == first && data[pos + 1] == second && readU32(data + pos) == signature) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+bool PayloadLocator::locateByTrailer(qint64 &archiveOffset, qint64 &archiveSize)
+{
+    QByteArray storage;
+    const uchar *trailer = view(m_fileSize - TRAILER_SIZE, TRAILER_SIZE, storage);
+    if (!trailer || memcmp(trailer, TRAILER_MAGIC, TRAILER_MAGIC_SIZE) != 0) {
+        return false;
+    }
+
+    qint64 zipOffset = qint64(readU64(trailer + TRAILER_MAGIC_SIZE));
+    qint64 zipSize = qint64(readU64(trailer + TRAILER_MAGIC_SIZE + 8));
+
+    // 验证数据的合理性
+    if (zipOffset < 0 || zipSize < END_OF_CENTRAL_DIR_SIZE
+        || zipOffset > m_fileSize - TRAILER_SIZE - zipSize) {
+        return false;
+    }
+
+    // 安装清单只需再读一小块，出错时忽略清单，退回解析中央目录
+    qint64 metadataSize = readU32(trailer + TRAILER_MAGIC_SIZE + 16);
+    if (metadataSize > TRAILER_SIZE && zipOffset + zipSize == m_fileSize - metadataSize) {
+        QByteArray manifestStorage;
+        const uchar *manifest = view(zipOffset + zipSize, metadataSize - TRAILER_SIZE, manifestStorage);
+        if (manifest) {
+            m_manifest = QByteArray(reinterpret_cast<const char *>(manifest), int(metadataSize - TRAILER_SIZE));
+        }
+        readChecksum(zipOffset);
+    }
+
+    // 分帧载荷不是 ZIP，只能依靠清单中的帧表解压，没有清单就无法安装
+    QByteArray headerStorage;
+    const uchar *header = view(zipOffset, ZipIndex::FRAMED_PAYLOAD_HEADER_SIZE, headerStorage);
+    if (header && memcmp(header, ZipIndex::FRAMED_PAYLOAD_MAGIC, ZipIndex::FRAMED_PAYLOAD_HEADER_SIZE) == 0) {
+        if (m_manifest.isEmpty()) {
+            return false;
+        }
+        archiveOffset = zipOffset;
+        archiveSize = zipSize;
+        return true;
+    }
+
+    // 验证 ZIP 文件头和结束记录都在预期位置
+    QByteArray endStorage;
+    const uchar *endRecord = view(zipOffset + zipSize - END_OF_CENTRAL_DIR_SIZE, 4, endStorage);
+    if (!isLocalHeaderAt(zipOffset) || !endRecord
+        || readU32(endRecord) != END_OF_CENTRAL_DIR_SIGNATURE) {
+        m_manifest.clear();
+        return false;
+    }
+
+    archiveOffset = zipOffset;
+    archiveSize = zipSize;
+    return true;
+}
+
+void PayloadLocator::readChecksum(qint64 archiveOffset)
+{
+    if (m_manifest.size() < CHECKSUM_BLOCK_SIZE) {
+        return;
+    }
+    const uchar *block = reinterpret_cast<const uchar *>(m_manifest.constData())
+                         + m_manifest.size() - CHECKSUM_BLOCK_SIZE;
+    if (memcmp(block, CHECKSUM_MAGIC, CHECKSUM_MAGIC_SIZE) != 0) {
+        return;
+    }
+
+    // 覆盖范围是压缩包起点到校验块之前，也就是载荷加安装清单
+    m_checksum.leafSize = int(readU32(block + CHECKSUM_MAGIC_SIZE));
+    m_checksum.coveredSize = qint64(readU64(block + CHECKSUM_MAGIC_SIZE + 8));
+    m_checksum.rootHash = QByteArray(reinterpret_cast<const char *>(block + CHECKSUM_MAGIC_SIZE + 16),
+                                     PayloadChecksum::HASH_SIZE);
+    m_manifest.chop(CHECKSUM_BLOCK_SIZE);
+
+    qint64 expectedSize = m_fileSize - TRAILER_SIZE - CHECKSUM_BLOCK_SIZE - archiveOffset;
+    if (m_checksum.leafSize <= 0 || m_checksum.coveredSize != expectedSize) {
+        // 校验块本身不合理，按损坏处理：保留一个必然不匹配的记录
+        m_checksum.leafSize = qMax(1, m_checksum.leafSize);
+        m_checksum.coveredSize = qMax<qint64>(1, qMin(m_checksum.coveredSize, expectedSize));
+        m_checksum.rootHash.fill('\0');
+    }
+}
+
+bool PayloadLocator::locateByEndRecord(qint64 &archiveOffset, qint64 &archiveSize)
+{
+    qint64 tailSize = qMin(m_fileSize, qint64(END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE + TRAILER_SIZE));
+    qint64 tailStart = m_fileSize - tailSize;
+    QByteArray storage;
+    const uchar *tail = view(tailStart, tailSize, storage);
+    if (!tail) {
+        return false;
+    }
+
+    // 从后往前逐个检查结束记录候选，直到根据中央目录推算出的起点上确实是文件头
+    qint64 limit = tailSize;
+    forever {
+        qint64 pos = findLastSignature(tail, limit, END_OF_CENTRAL_DIR_SIGNATURE);
+        if (pos < 0) {
+            return false;
+        }
+        limit = pos + 3;
+
+        if (pos + END_OF_CENTRAL_DIR_SIZE > tailSize) {
+            continue;
+        }
+        const uchar *record = tail + pos;
+        qint64 endRecordPos = tailStart + pos;
+        qint64 centralDirSize = readU32(record + 12);
+        qint64 centralDirOffset = readU32(record + 16);
+        qint64 zipEndPos = endRecordPos + END_OF_CENTRAL_DIR_SIZE + readU16(record + 20);
+        if (zipEndPos > m_fileSize) {
+            continue;
+        }
+
+        // ZIP64：中央目录的位置和大小在 ZIP64 结束记录里
+        qint64 directoryEnd = endRecordPos;
+        if (centralDirSize == 0xffffffff || centralDirOffset == 0xffffffff) {
+            QByteArray zip64Storage;
+            qint64 zip64Pos = endRecordPos - ZIP64_LOCATOR_SIZE - ZIP64_END_OF_CENTRAL_DIR_SIZE;
+            const uchar *zip64 = view(zip64Pos, ZIP64_END_OF_CENTRAL_DIR_SIZE + ZIP64_LOCATOR_SIZE, zip64Storage);
+            if (!zip64 || readU32(zip64) != ZIP64_END_OF_CENTRAL_DIR_SIGNATURE
+                || readU32(zip64 + ZIP64_END_OF_CENTRAL_DIR_SIZE) != ZIP64_LOCATOR_SIGNATURE) {
+                continue;
+            }
+            centralDirSize = qint64(readU64(zip64 + 40));
+            centralDirOffset = qint64(readU64(zip64 + 48));
+            directoryEnd = zip64Pos;
+        }
+
+        // 根据中央目录偏移计算 ZIP 文件开始位置
+        qint64 zipStartPos = directoryEnd - centralDirSize - centralDirOffset;
+        if (centralDirSize < 0 || centralDirOffset < 0 || zipStartPos < 0 || !isLocalHeaderAt(zipStartPos)) {
+            continue;
+        }
+
+        archiveOffset = zipStartPos;
+        archiveSize = zipEndPos - zipStartPos;
+        return true;
+    }
+}
+
+bool PayloadLocator::locateByLocalHeader(qint64 &archiveOffset, qint64 &archiveSize)
+{
+    qint64 endPos = 0;
+    if (!archiveEnd(endPos)) {
+        return false;
+    }
+
+    // 能识别镜像格式时直接从镜像结束处开始，避免误中代码段里的常量
+    qint64 scanStart = imageEnd();
+    if (scanStart < 0) {
+        scanStart = qMax(0LL, endPos - MAX_SCAN_SIZE);
+    }
+    qint64 scanEnd = qMin(endPos, scanStart + MAX_SCAN_SIZE);
+
+    qint64 blockStart = scanStart;
+    while (blockStart + 4 <= scanEnd) {
+        qint64 blockSize = qMin(SCAN_BLOCK_SIZE, scanEnd - blockStart);
+        QByteArray storage;
+        const uchar *block = view(blockStart, blockSize, storage);
+        if (!block) {
+            return false;
+        }
+
+        qint64 searchFrom = 0;
+        forever {
+            qint64 hit = findSignature(block + searchFrom, blockSize - searchFrom, LOCAL_HEADER_SIGNATURE);
+            if (hit < 0) {
+                break;
+            }
+            qint64 candidate = blockStart + searchFrom + hit;
+            if (isLocalHeaderAt(candidate)) {
+                archiveOffset = candidate;
+                archiveSize = endPos - candidate;
+                return true;
+            }
+            searchFrom += hit + 1;
+        }
+
+        if (blockStart + blockSize >= scanEnd) {
+            break;
+        }
+        blockStart += blockSize - 3;
+    }
+    return false;
+}
+
+bool PayloadLocator::archiveEnd(qint64 &endPos)
+{
+    qint64 tailSize = qMin(m_fileSize, qint64(END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE + TRAILER_SIZE));
+    qint64 tailStart = m_fileSize - tailSize;
+    QByteArray storage;
+    const uchar *tail = view(tailStart, tailSize, storage);
+    if (!tail) {
+        return false;
+    }
+
+    qint64 limit = tailSize;
+    qint64 pos;
+    while ((pos = findLastSignature(tail, limit, END_OF_CENTRAL_DIR_SIGNATURE)) >= 0) {
+        limit = pos + 3;
+        if (pos + END_OF_CENTRAL_DIR_SIZE <= tailSize
+            && pos + END_OF_CENTRAL_DIR_SIZE + readU16(tail + pos + 20) <= tailSize) {
+            endPos = tailStart + pos + END_OF_CENTRAL_DIR_SIZE + readU16(tail + pos + 20);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PayloadLocator::isLocalHeaderAt(qint64 offset)
+{
+    QByteArray storage;
+    const uchar *header = view(offset, LOCAL_HEADER_SIZE, storage);
+    if (!header || readU32(header) != LOCAL_HEADER_SIGNATURE) {
+        return false;
+    }
+
+    qint64 nameLength = readU16(header + 26);
+    qint64 extraLength = readU16(header + 28);
+    return nameLength > 0 && offset + LOCAL_HEADER_SIZE + nameLength + extraLength <= m_fileSize;
+}
+
+qint64 PayloadLocator::imageEnd()
+{
+    if (!open()) {
+        return -1;
+    }
+
+    qint64 end = peImageEnd();
+    if (end < 0) {
+        end = elfImageEnd();
+    }
+    return end;
+}
+
+qint64 PayloadLocator::peImageEnd()
+{
+    QByteArray storage;
+    const uchar *dosHeader = view(0, 64, storage);
+    if (!dosHeader || dosHeader[0] != 'M' || dosHeader[1] != 'Z') {
+        return -1;
+    }
+
+    // PE 签名之后是 20 字节的 COFF 文件头，再之后是可选头和节表
+    qint64 peOffset = readU32(dosHeader + 0x3c);
+    QByteArray peStorage;
+    const uchar *peHeader = view(peOffset, 24, peStorage);
+    if (!peHeader || memcmp(peHeader, "PE\0\0", 4) != 0) {
+        return -1;
+    }
+    int sectionCount = readU16(peHeader + 6);
+    qint64 sectionTable = peOffset + 24 + readU16(peHeader + 20);
+
+    QByteArray sectionStorage;
+    const uchar *sections = view(sectionTable, qint64(sectionCount) * 40, sectionStorage);
+    if (!sections) {
+        return -1;
+    }
+
+    // 镜像结束位置 = 所有节在文件中的最大结束偏移
+    qint64 end = sectionTable + qint64(sectionCount) * 40;
+    for (int i = 0; i < sectionCount; i++) {
+        const uchar *section = sections + i * 40;
+        end = qMax(end, qint64(readU32(section + 20)) + qint64(readU32(section + 16)));
+    }
+    return end <= m_fileSize ? end : -1;
+}
+
+qint64 PayloadLocator::elfImageEnd()
+{
+    QByteArray storage;
+    const uchar *header = view(0, 64, storage);
+    if (!header || memcmp(header, "\x7f" "ELF", 4) != 0 || header[5] != 1) {
+        // 只处理小端 ELF
+        return -1;
+    }
+
+    bool is64 = header[4] == 2;
+    qint64 programOffset = is64 ? qint64(readU64(header + 0x20)) : readU32(header + 0x1c);
+    qint64 sectionOffset = is64 ? qint64(readU64(header + 0x28)) : readU32(header + 0x20);
+    int programEntrySize = readU16(header + (is64 ? 0x36 : 0x2a));
+    int programCount = readU16(header + (is64 ? 0x38 : 0x2c));
+    int sectionEntrySize = readU16(header + (is64 ? 0x3a : 0x2e));
+    int sectionCount = readU16(header + (is64 ? 0x3c : 0x30));
+
+    qint64 end = is64 ? 64 : 52;
+
+    QByteArray programStorage;
+    const uchar *programs = view(programOffset, qint64(programCount) * programEntrySize, programStorage);
+    if (programCount > 0) {
+        if (!programs || programEntrySize < (is64 ? 56 : 32)) {
+            return -1;
+        }
+        end = qMax(end, programOffset + qint64(programCount) * programEntrySize);
+        for (int i = 0; i < programCount; i++) {
+            const uchar *entry = programs + qint64(i) * programEntrySize;
+            qint64 offset = is64 ? qint64(readU64(entry + 8)) : readU32(entry + 4);
+            qint64 fileSize = is64 ? qint64(readU64(entry + 32)) : readU32(entry + 16);
+            end = qMax(end, offset + fileSize);
+        }
+    }
+
+    // 节头表通常位于 ELF 文件最后
+    QByteArray sectionStorage;
+    const uchar *sections = view(sectionOffset, qint64(sectionCount) * sectionEntrySize, sectionStorage);
+    if (sectionCount > 0) {
+        if (!sections || sectionEntrySize < (is64 ? 64 : 40)) {
+            return -1;
+        }
+        end = qMax(end, sectionOffset + qint64(sectionCount) * sectionEntrySize);
+        for (int i = 0; i < sectionCount; i++) {
+            const uchar *entry = sections + qint64(i) * sectionEntrySize;
+            if (readU32(entry + 4) == ELF_SECTION_NOBITS) {
+                continue;
+            }
+            qint64 offset = is64 ? qint64(readU64(entry + 0x18)) : readU32(entry + 0x10);
+            qint64 size = is64 ? qint64(readU64(entry + 0x20)) : readU32(entry + 0x14);
+            end = qMax(end, offset + size);
+        }
+    }
+    return end <= m_fileSize ? end : -1;
+}
@@ -0,0 +1,56 @@
+#ifndef PAYLOADLOCATOR_H
+#define PAYLOADLOCATOR_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "payloadverifier.h"
+
+// 定位安装程序自身末尾附加的 ZIP 压缩包
+// 整个文件优先映射到内存（失败时退回按块读取），签名按 16 字节一组向量化查找，
+// 能解析 PE/ELF 头时直接从镜像结束位置（overlay）开始找压缩包
+class PayloadLocator
+{
+public:
+    explicit PayloadLocator(const QString &filePath);
+    ~PayloadLocator();
+
+    bool locate(qint64 &archiveOffset, qint64 &archiveSize);
+
+    // 新格式元数据中附带的安装清单，旧格式或其他定位方式下为空
+    QByteArray manifest() const;
+
+    // 末尾元数据中记录的整体校验值，旧格式安装包没有时 isValid() 为 false
+    PayloadChecksum checksum() const;
+
+    // PE/ELF 镜像本身结束的位置，无法识别文件格式时返回 -1
+    qint64 imageEnd();
+
+    // 在 data 中查找第一个/最后一个 4 字节小端签名，找不到返回 -1
+    static qint64 findSignature(const uchar *data, qint64 size, quint32 signature);
+    static qint64 findLastSignature(const uchar *data, qint64 size, quint32 signature);
+
+private:
+    bool open();
+    void close();
+    const uchar *view(qint64 offset, qint64 size, QByteArray &storage);
+
+    bool locateByTrailer(qint64 &archiveOffset, qint64 &archiveSize);
+    void readChecksum(qint64 archiveOffset);
+    bool locateByEndRecord(qint64 &archiveOffset, qint64 &archiveSize);
+    bool locateByLocalHeader(qint64 &archiveOffset, qint64 &archiveSize);
+    bool archiveEnd(qint64 &endPos);
+    bool isLocalHeaderAt(qint64 offset);
+
+    qint64 peImageEnd();
+    qint64 elfImageEnd();
+
+    QFile m_file;
+    qint64 m_fileSize;
+    uchar *m_map;
+    QByteArray m_manifest;
+    PayloadChecksum m_checksum;
+};
+
+#endif // PAYLOADLOCATOR_H
@@ -0,0 +1,150 @@
+#include "payloadverifier.h"
+#include "memorybudget.h"
+
+#include <QCryptographicHash>
+#include <QThread>
+#include <QtEndian>
+
+#include <cstring>
+#include <utility>
+
+PayloadVerifier::PayloadVerifier(const QString &filePath, qint64 offset, const PayloadChecksum &checksum)
+    : m_filePath(filePath)
+    , m_offset(offset)
+    , m_checksum(checksum)
+    , m_leafCount(0)
+    , m_memoryBudget(0)
+    , m_file(filePath)
+    , m_map(nullptr)
+    , m_leafHashData(nullptr)
+    , m_nextLeaf(0)
+    , m_failed(0)
+{
+}
+
+PayloadVerifier::~PayloadVerifier()
+{
+    wait();
+}
+
+void PayloadVerifier::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+}
+
+void PayloadVerifier::start(int threadCount)
+{
+    if (!m_workers.isEmpty() || !m_checksum.isValid()) {
+        return;
+    }
+
+    m_leafCount = (m_checksum.coveredSize + m_checksum.leafSize - 1) / m_checksum.leafSize;
+    m_leafHashes = QByteArray(int(m_leafCount * PayloadChecksum::HASH_SIZE), '\0');
+    m_leafHashData = m_leafHashes.data();
+    m_nextLeaf.storeRelaxed(0);
+    m_failed.storeRelaxed(0);
+
+    // 文件比记录的范围短说明被截断；整体映射失败时，各线程用自己的文件句柄按叶子读取
+    if (!m_file.open(QIODevice::ReadOnly) || m_offset + m_checksum.coveredSize > m_file.size()) {
+        m_failed.storeRelaxed(1);
+        return;
+    }
+    m_map = m_file.map(m_offset, m_checksum.coveredSize);
+
+    int workerCount = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    workerCount = int(qMin<qint64>(workerCount, m_leafCount));
+    if (!m_map && m_memoryBudget > 0) {
+        workerCount = int(qBound<qint64>(1, m_memoryBudget / m_checksum.leafSize, workerCount));
+    }
+    for (int i = 0; i < workerCount; i++) {
+        QThread *thread = QThread::create([this]() { workerLoop(); });
+        m_workers.append(thread);
+        thread->start();
+    }
+}
+
+bool PayloadVerifier::wait()
+{
+    // 旧格式安装包没有记录校验值，不做检查
+    if (!m_checksum.isValid()) {
+        return true;
+    }
+
+    for (QThread *thread : std::as_const(m_workers)) {
+        thread->wait();
+        delete thread;
+    }
+    m_workers.clear();
+
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+
+    if (m_failed.loadRelaxed() != 0 || m_leafCount == 0) {
+        return false;
+    }
+    return rootHash(m_leafHashes, m_checksum.coveredSize, m_checksum.leafSize) == m_checksum.rootHash;
+}
+
+QByteArray PayloadVerifier::rootHash(const QByteArray &leafHashes, qint64 coveredSize, int leafSize)
+{
+    // 根哈希同时覆盖叶子大小和总长度，截断或改变切分方式都会导致不一致
+    QByteArray header(12, '\0');
+    qToLittleEndian<quint32>(quint32(leafSize), header.data());
+    qToLittleEndian<quint64>(quint64(coveredSize), header.data() + 4);
+
+    QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+    hash.addData(header);
+    hash.addData(leafHashes);
+    return hash.result();
+}
+
+void PayloadVerifier::workerLoop()
+{
+    QFile file(m_filePath);
+    if (!m_map && !file.open(QIODevice::ReadOnly)) {
+        m_failed.storeRelaxed(1);
+        return;
+    }
+
+    QByteArray buffer;
+    while (m_failed.loadRelaxed() == 0) {
+        qint64 leaf = m_nextLeaf.fetchAndAddRelaxed(1);
+        if (leaf >= m_leafCount) {
+            break;
+        }
+        if (!hashLeaf(file, leaf, buffer)) {
+            m_failed.storeRelaxed(1);
+        }
+    }
+}
+
+bool PayloadVerifier::hashLeaf(QFile &file, qint64 leaf, QByteArray &buffer)
+{
+    qint64 start = leaf * m_checksum.leafSize;
+    qint64 length = qMin<qint64>(m_checksum.leafSize, m_checksum.coveredSize - start);
+
+    const uchar *data = nullptr;
+    if (m_map) {
+        data = m_map + start;
+    } else {
+        buffer.resize(int(length));
+        if (!file.seek(m_offset + start) || file.read(buffer.data(), length) != length) {
+            return false;
+        }
+        data = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+    hash.addData(QByteArrayView(data, length));
+    QByteArray result = hash.result();
+    if (m_map && m_memoryBudget > 0) {
+        MemoryBudget::releasePages(data, length);
+    }
+
+    // 每个线程只写自己领取的叶子对应的位置
+    memcpy(m_leafHashData + leaf * PayloadChecksum::HASH_SIZE, result.constData(), PayloadChecksum::HASH_SIZE);
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef PAYLOADVERIFIER_H
+#define PAYLOADVERIFIER_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class QThread;
+
+// append_zip.py 记录的整体校验值：从压缩包起点开始的 coveredSize 字节（载荷加安装清单）
+// 按 leafSize 切成叶子，每个叶子求 BLAKE2b-256，再对各叶子哈希求一次根哈希
+struct PayloadChecksum
+{
+    qint64 coveredSize = 0;
+    int leafSize = 0;
+    QByteArray rootHash;
+
+    bool isValid() const { return leafSize > 0 && coveredSize > 0 && rootHash.size() == HASH_SIZE; }
+
+    static const int HASH_SIZE = 32;
+};
+
+// 在后台线程中并行计算树哈希，安装线程同时继续解析清单、比较已安装的文件，
+// 在修改磁盘上的任何内容之前再等待结果
+class PayloadVerifier
+{
+public:
+    PayloadVerifier(const QString &filePath, qint64 offset, const PayloadChecksum &checksum);
+    ~PayloadVerifier();
+
+    // 有内存上限（字节）时，算过的叶子移出工作集；不能整体映射时，各线程的读取缓冲也不超过上限。
+    // 在 start() 之前设置
+    void setMemoryBudget(qint64 bytes);
+
+    // 0 表示使用 QThread::idealThreadCount()
+    void start(int threadCount);
+
+    // 等待所有线程结束，返回计算出的根哈希是否与记录一致
+    bool wait();
+
+    static QByteArray rootHash(const QByteArray &leafHashes, qint64 coveredSize, int leafSize);
+
+private:
+    void workerLoop();
+    bool hashLeaf(QFile &file, qint64 leaf, QByteArray &buffer);
+
+    QString m_filePath;
+    qint64 m_offset;
+    PayloadChecksum m_checksum;
+    qint64 m_leafCount;
+    qint64 m_memoryBudget;
+
+    QFile m_file;
+    uchar *m_map;
+    QByteArray m_leafHashes;
+    char *m_leafHashData;   // 各线程直接写入，避免并发调用 QByteArray::data()
+    QAtomicInteger<qint64> m_nextLeaf;
+    QAtomicInteger<int> m_failed;
+    QVector<QThread *> m_workers;
+};
+
+#endif // PAYLOADVERIFIER_H
@@ -0,0 +1,124 @@
+#include "progresstracker.h"
+#include "zipindex.h"
+
+namespace {
+
+// 指数平滑系数，越大越跟随瞬时速度
+const double RATE_SMOOTHING = 0.3;
+
+// 采样间隔太短时速度抖动大，低于该间隔沿用上次的速度
+const qint64 MIN_SAMPLE_MS = 100;
+
+QString formatDuration(qint64 ms)
+{
+    qint64 seconds = (ms + 999) / 1000;
+    return QString("%1:%2")
+        .arg(seconds / 60, 2, 10, QLatin1Char('0'))
+        .arg(seconds % 60, 2, 10, QLatin1Char('0'));
+}
+
+} // namespace
+
+ProgressTracker::ProgressTracker()
+    : m_compressedRead(0)
+    , m_bytesWritten(0)
+    , m_filesDone(0)
+    , m_totalCompressed(0)
+    , m_totalUncompressed(0)
+    , m_totalFiles(0)
+    , m_lastSampleMs(0)
+    , m_lastBytes(0)
+    , m_lastFiles(0)
+    , m_bytesRate(0.0)
+    , m_filesRate(0.0)
+{
+}
+
+void ProgressTracker::reset(const QVector<ZipEntry> &entries)
+{
+    m_totalCompressed = 0;
+    m_totalUncompressed = 0;
+    m_totalFiles = 0;
+    for (const ZipEntry &entry : entries) {
+        if (entry.isDir) {
+            continue;
+        }
+        m_totalCompressed += entry.compressedSize;
+        m_totalUncompressed += entry.uncompressedSize;
+        m_totalFiles++;
+    }
+
+    m_compressedRead.storeRelaxed(0);
+    m_bytesWritten.storeRelaxed(0);
+    m_filesDone.storeRelaxed(0);
+    m_lastSampleMs = 0;
+    m_lastBytes = 0;
+    m_lastFiles = 0;
+    m_bytesRate = 0.0;
+    m_filesRate = 0.0;
+    m_timer.start();
+}
+
+void ProgressTracker::addCompressedRead(qint64 bytes)
+{
+    m_compressedRead.fetchAndAddRelaxed(bytes);
+}
+
+void ProgressTracker::addBytesWritten(qint64 bytes)
+{
+    m_bytesWritten.fetchAndAddRelaxed(bytes);
+}
+
+void ProgressTracker::addFileDone(int count)
+{
+    m_filesDone.fetchAndAddRelaxed(count);
+}
+
+ProgressTracker::Snapshot ProgressTracker::snapshot()
+{
+    Snapshot s;
+    s.compressedRead = m_compressedRead.loadRelaxed();
+    s.totalCompressed = m_totalCompressed;
+    s.bytesWritten = m_bytesWritten.loadRelaxed();
+    s.totalUncompressed = m_totalUncompressed;
+    s.filesDone = m_filesDone.loadRelaxed();
+    s.totalFiles = m_totalFiles;
+
+    // 读和写各占一半，两者都按字节推进
+    double readFraction = m_totalCompressed > 0 ? double(s.compressedRead) / m_totalCompressed : 1.0;
+    double writeFraction = m_totalUncompressed > 0 ? double(s.bytesWritten) / m_totalUncompressed : 1.0;
+    s.fraction = qBound(0.0, (readFraction + writeFraction) / 2.0, 1.0);
+
+    qint64 now = m_timer.isValid() ? m_timer.elapsed() : 0;
+    qint64 interval = now - m_lastSampleMs;
+    if (interval >= MIN_SAMPLE_MS) {
+        double bytesRate = (s.bytesWritten - m_lastBytes) * 1000.0 / interval;
+        double filesRate = (s.filesDone - m_lastFiles) * 1000.0 / interval;
+        bool firstSample = m_lastSampleMs == 0;
+        m_bytesRate = firstSample ? bytesRate : m_bytesRate + RATE_SMOOTHING * (bytesRate - m_bytesRate);
+        m_filesRate = firstSample ? filesRate : m_filesRate + RATE_SMOOTHING * (filesRate - m_filesRate);
+        m_lastSampleMs = now;
+        m_lastBytes = s.bytesWritten;
+        m_lastFiles = s.filesDone;
+    }
+    s.bytesPerSecond = m_bytesRate;
+    s.filesPerSecond = m_filesRate;
+
+    qint64 remaining = m_totalUncompressed - s.bytesWritten;
+    s.etaMs = (m_bytesRate > 0.0 && remaining >= 0) ? qint64(remaining * 1000.0 / m_bytesRate) : -1;
+
+    return s;
+}
+
+QString ProgressTracker::formatMessage(const Snapshot &snapshot)
+{
+    QString message = QString("正在解压 %1/%2 个文件，%3 MB/s，%4 个文件/秒")
+                          .arg(snapshot.filesDone)
+                          .arg(snapshot.totalFiles)
+                          .arg(snapshot.bytesPerSecond / (1024.0 * 1024.0), 0, 'f', 1)
+                          .arg(snapshot.filesPerSecond, 0, 'f', 0);
+    if (snapshot.etaMs >= 0) {
+        message += QString("，剩余约 %1").arg(formatDuration(snapshot.etaMs));
+    }
+    return message;
+}
\ No newline at end of file
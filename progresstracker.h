@@ -0,0 +1,58 @@
+#ifndef PROGRESSTRACKER_H
+#define PROGRESSTRACKER_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+struct ZipEntry;
+
+// 按字节统计解压进度：读取的压缩字节与写出的解压字节，总量来自中央目录。
+// 计数由各解压/写入线程原子累加，快照由安装线程按刷新间隔读取
+class ProgressTracker
+{
+public:
+    struct Snapshot {
+        qint64 compressedRead;
+        qint64 totalCompressed;
+        qint64 bytesWritten;
+        qint64 totalUncompressed;
+        int filesDone;
+        int totalFiles;
+        double fraction;            // 0.0 ~ 1.0
+        double bytesPerSecond;      // 写出速度（平滑后）
+        double filesPerSecond;
+        qint64 etaMs;               // 预计剩余时间，未知时为 -1
+    };
+
+    ProgressTracker();
+
+    void reset(const QVector<ZipEntry> &entries);
+
+    void addCompressedRead(qint64 bytes);
+    void addBytesWritten(qint64 bytes);
+    void addFileDone(int count = 1);
+
+    Snapshot snapshot();
+
+    static QString formatMessage(const Snapshot &snapshot);
+
+private:
+    QAtomicInteger<qint64> m_compressedRead;
+    QAtomicInteger<qint64> m_bytesWritten;
+    QAtomicInteger<int> m_filesDone;
+    qint64 m_totalCompressed;
+    qint64 m_totalUncompressed;
+    int m_totalFiles;
+
+    // 速度平滑，只由读取快照的线程访问
+    QElapsedTimer m_timer;
+    qint64 m_lastSampleMs;
+    qint64 m_lastBytes;
+    int m_lastFiles;
+    double m_bytesRate;
+    double m_filesRate;
+};
+
+#endif // PROGRESSTRACKER_H
\ No newline at end of file
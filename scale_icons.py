@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+import os
+import argparse
+import struct
+import zlib
+
+# 界面中的图标按显示尺寸预先缩放好放进资源，启动时不再解码 1024x1024 的原图再平滑缩放。
+# 同时生成 1 倍和 2 倍（@2x）两种尺寸，高分屏上直接使用 @2x
+ICON_SIZE = 100
+SCALES = (1, 2)
+ICONS = ('welcome', 'installing', 'success')
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+COLOR_TYPE_RGBA = 6
+
+
+def read_png(path):
+    """Decode an 8-bit, non-interlaced RGBA PNG into (width, height, rows of bytes)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data.startswith(PNG_SIGNATURE):
+        raise ValueError("%s is not a PNG file" % path)
+
+    pos = len(PNG_SIGNATURE)
+    idat = []
+    header = None
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b'IHDR':
+            header = struct.unpack('>IIBBBBB', body)
+        elif kind == b'IDAT':
+            idat.append(body)
+        elif kind == b'IEND':
+            break
+        pos += 12 + length
+
+    width, height, depth, color, _, _, interlace = header
+    if depth != 8 or color != COLOR_TYPE_RGBA or interlace != 0:
+        raise ValueError("%s: only 8-bit non-interlaced RGBA is supported" % path)
+
+    raw = zlib.decompress(b''.join(idat))
+    stride = width * 4
+    rows = []
+    previous = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        kind = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            left = row[i - 4] if i >= 4 else 0
+            up = previous[i]
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xff
+            elif kind == 2:
+                row[i] = (row[i] + up) & 0xff
+            elif kind == 3:
+                row[i] = (row[i] + ((left + up) >> 1)) & 0xff
+            elif kind == 4:
+                upper_left = previous[i - 4] if i >= 4 else 0
+                p = left + up - upper_left
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - upper_left)
+                predictor = left if pa <= pb and pa <= pc else (up if pb <= pc else upper_left)
+                row[i] = (row[i] + predictor) & 0xff
+        rows.append(row)
+        previous = row
+    return width, height, rows
+
+
+def write_png(path, width, height, rows):
+    def chunk(kind, body):
+        return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', zlib.crc32(kind + body))
+
+    raw = b''.join(b'\x00' + bytes(row) for row in rows)
+    with open(path, 'wb') as f:
+        f.write(PNG_SIGNATURE)
+        f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, COLOR_TYPE_RGBA, 0, 0, 0)))
+        f.write(chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(chunk(b'IEND', b''))
+
+
+def area_weights(source, target):
+    """For every target pixel, the (source index, coverage) pairs of a box filter."""
+    scale = source / target
+    weights = []
+    for t in range(target):
+        start, end = t * scale, (t + 1) * scale
+        taps = []
+        s = int(start)
+        while s < end and s < source:
+            coverage = min(end, s + 1) - max(start, s)
+            if coverage > 0:
+                taps.append((s, coverage / scale))
+            s += 1
+        weights.append(taps)
+    return weights
+
+
+def downscale(width, height, rows, size):
+    """Area-average resample to size x size, with premultiplied alpha so edges do not darken."""
+    x_weights = area_weights(width, size)
+    y_weights = area_weights(height, size)
+
+    # 先横向再纵向，都在预乘 alpha 的浮点值上进行
+    horizontal = []
+    for row in rows:
+        out = []
+        for taps in x_weights:
+            r = g = b = a = 0.0
+            for s, w in taps:
+                alpha = row[s * 4 + 3] * w
+                r += row[s * 4] * alpha
+                g += row[s * 4 + 1] * alpha
+                b += row[s * 4 + 2] * alpha
+                a += alpha
+            out.append((r, g, b, a))
+        horizontal.append(out)
+
+    result = []
+    for taps in y_weights:
+        row = bytearray(size * 4)
+        for x in range(size):
+            r = g = b = a = 0.0
+            for s, w in taps:
+                pr, pg, pb, pa = horizontal[s][x]
+                r += pr * w
+                g += pg * w
+                b += pb * w
+                a += pa * w
+            if a > 0:
+                row[x * 4] = min(255, int(r / a + 0.5))
+                row[x * 4 + 1] = min(255, int(g / a + 0.5))
+                row[x * 4 + 2] = min(255, int(b / a + 0.5))
+            row[x * 4 + 3] = min(255, int(a + 0.5))
+        result.append(row)
+    return result
+
+
+def icon_file_name(name, scale):
+    return "%s.png" % name if scale == 1 else "%s@%dx.png" % (name, scale)
+
+
+def scale_icons(source_dir, output_dir):
+    os.makedirs(output_dir, exist_ok=True)
+    for name in ICONS:
+        width, height, rows = read_png(os.path.join(source_dir, name + '.png'))
+        for scale in SCALES:
+            size = ICON_SIZE * scale
+            path = os.path.join(output_dir, icon_file_name(name, scale))
+            write_png(path, size, size, downscale(width, height, rows, size))
+            print("%s -> %s (%dx%d)" % (name, path, size, size))
+
+
+if __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Pre-scale the installer's UI icons to their display size")
+    parser.add_argument("--source", default=os.path.join(here, "images"))
+    parser.add_argument("--output", default=os.path.join(here, "images", "icons"))
+    args = parser.parse_args()
+    scale_icons(args.source, args.output)
@@ -0,0 +1,120 @@
+#include "silentinstaller.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonDocument>
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+SilentInstaller::SilentInstaller(const InstallOptions &options, const QString &targetDir, QObject *parent)
+    : QObject(parent)
+    , m_installer(nullptr)
+    , m_installerThread(nullptr)
+    , m_targetDir(QDir(targetDir).absolutePath())
+    , m_lastPercentage(-1)
+{
+    // 和界面模式一样在独立线程中运行安装器
+    m_installerThread = new QThread(this);
+    m_installer = new Installer();
+    m_installer->setOptions(options);
+    m_installer->setInstallPath(m_targetDir);
+    m_installer->moveToThread(m_installerThread);
+    connect(m_installerThread, &QThread::finished, m_installer, &QObject::deleteLater);
+
+    connect(m_installer, &Installer::progressUpdated, this, &SilentInstaller::onInstallationProgress, Qt::QueuedConnection);
+    connect(m_installer, &Installer::installationFinished, this, &SilentInstaller::onInstallationFinished, Qt::QueuedConnection);
+    connect(m_installer, &Installer::errorOccurred, this, &SilentInstaller::onInstallationError, Qt::QueuedConnection);
+    connect(m_installer, &Installer::reportWritten, this, &SilentInstaller::onReportWritten, Qt::QueuedConnection);
+}
+
+SilentInstaller::~SilentInstaller()
+{
+    m_installerThread->quit();
+    m_installerThread->wait();
+}
+
+void SilentInstaller::start()
+{
+    m_timer.start();
+    m_installerThread->start();
+
+    QJsonObject event;
+    event.insert(QStringLiteral("event"), QStringLiteral("start"));
+    event.insert(QStringLiteral("target"), m_targetDir);
+    writeEvent(event);
+
+    m_installer->sweepTrash();
+    m_installer->startInstallation();
+}
+
+void SilentInstaller::attachConsole()
+{
+#ifdef _WIN32
+    // 输出已被重定向（管道或文件）时保持不变
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    if ((output == nullptr || output == INVALID_HANDLE_VALUE) && AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+#endif
+}
+
+void SilentInstaller::onInstallationProgress(int percentage, const QString &message)
+{
+    if (percentage == m_lastPercentage) {
+        return;
+    }
+    m_lastPercentage = percentage;
+
+    QJsonObject event;
+    event.insert(QStringLiteral("event"), QStringLiteral("progress"));
+    event.insert(QStringLiteral("percent"), percentage);
+    event.insert(QStringLiteral("message"), message);
+    writeEvent(event);
+}
+
+void SilentInstaller::onInstallationFinished(bool success, const QString &message)
+{
+    QJsonObject event;
+    event.insert(QStringLiteral("event"), QStringLiteral("finished"));
+    event.insert(QStringLiteral("success"), success);
+    event.insert(QStringLiteral("message"), message);
+    writeEvent(event);
+
+    QCoreApplication::exit(success ? Success : InstallFailed);
+}
+
+void SilentInstaller::onInstallationError(const QString &error)
+{
+    QJsonObject event;
+    event.insert(QStringLiteral("event"), QStringLiteral("error"));
+    event.insert(QStringLiteral("success"), false);
+    event.insert(QStringLiteral("message"), error);
+    writeEvent(event);
+
+    QCoreApplication::exit(InstallFailed);
+}
+
+void SilentInstaller::onReportWritten(const QString &path, const QJsonObject &report)
+{
+    // 报告在结束事件之前到达（同一线程发出的排队信号按顺序投递）
+    QJsonObject event;
+    event.insert(QStringLiteral("event"), QStringLiteral("report"));
+    event.insert(QStringLiteral("path"), path);
+    event.insert(QStringLiteral("report"), report);
+    writeEvent(event);
+}
+
+void SilentInstaller::writeEvent(QJsonObject event)
+{
+    // 每个事件都带上从开始安装起的耗时
+    event.insert(QStringLiteral("elapsedMs"), m_timer.elapsed());
+    QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    fwrite(line.constData(), 1, size_t(line.size()), stdout);
+    fflush(stdout);
+}
@@ -0,0 +1,49 @@
+#ifndef SILENTINSTALLER_H
+#define SILENTINSTALLER_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QThread>
+
+#include "installer.h"
+
+// 静默安装：不创建任何窗口，在 QCoreApplication 下运行 Installer。
+// 进度和耗时输出到标准输出，每行一个 JSON 对象，结束前输出各阶段的统计报告；
+// 安装结束时以退出码结束事件循环
+class SilentInstaller : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ExitCode {
+        Success = 0,
+        InstallFailed = 1,
+        UsageError = 2
+    };
+
+    SilentInstaller(const InstallOptions &options, const QString &targetDir, QObject *parent = nullptr);
+    ~SilentInstaller();
+
+    void start();
+
+    // Windows 上程序是 GUI 子系统，从命令行启动时需要连接到父进程的控制台才能输出
+    static void attachConsole();
+
+private slots:
+    void onInstallationProgress(int percentage, const QString &message);
+    void onInstallationFinished(bool success, const QString &message);
+    void onInstallationError(const QString &error);
+    void onReportWritten(const QString &path, const QJsonObject &report);
+
+private:
+    void writeEvent(QJsonObject event);
+
+    Installer *m_installer;
+    QThread *m_installerThread;
+    QString m_targetDir;
+    QElapsedTimer m_timer;
+    int m_lastPercentage;   // 百分比变化时才输出进度，避免刷屏
+};
+
+#endif // SILENTINSTALLER_H
@@ -0,0 +1,119 @@
+#include "stagedinstall.h"
+#include "filecloner.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+
+namespace {
+
+const char STAGING_SUFFIX[] = ".staging";
+const char PREVIOUS_SUFFIX[] = ".previous";
+
+} // namespace
+
+StagedInstall::StagedInstall(const QString &targetDir)
+    : m_targetDir(QDir::cleanPath(QDir(targetDir).absolutePath()))
+    , m_failedCalls(0)
+{
+    m_stagingDir = siblingPath(STAGING_SUFFIX);
+    m_previousDir = siblingPath(PREVIOUS_SUFFIX);
+}
+
+bool StagedInstall::prepare(bool resume)
+{
+    QFileInfo target(m_targetDir);
+    if (!QDir().mkpath(target.path())) {
+        m_failedCalls++;
+        return false;
+    }
+
+    // 上次在两次改名之间中断：安装目录不存在而旧版本还在，先改回原处
+    if (!target.exists() && QFileInfo::exists(m_previousDir)
+        && !QDir().rename(m_previousDir, m_targetDir)) {
+        m_failedCalls++;
+    }
+
+    if (resume && QFileInfo(m_stagingDir).isDir()) {
+        return true;
+    }
+
+    // 上次失败留下的临时目录
+    if (QFileInfo::exists(m_stagingDir) && !QDir(m_stagingDir).removeRecursively()) {
+        m_failedCalls++;
+        return false;
+    }
+    if (!QDir().mkdir(m_stagingDir)) {
+        m_failedCalls++;
+        return false;
+    }
+    return true;
+}
+
+int StagedInstall::failedCalls() const
+{
+    return m_failedCalls;
+}
+
+QString StagedInstall::stagingDir() const
+{
+    return m_stagingDir;
+}
+
+bool StagedInstall::carryOver(const QStringList &relativePaths)
+{
+    QDir target(m_targetDir);
+    QDir staging(m_stagingDir);
+    QSet<QString> createdDirs;
+    for (const QString &path : relativePaths) {
+        // 大部分上级目录已经在解压时创建，用户自己的目录在这里补上
+        QString parent = QFileInfo(path).path();
+        if (parent != QLatin1String(".") && !createdDirs.contains(parent)) {
+            if (!staging.mkpath(parent)) {
+                return false;
+            }
+            createdDirs.insert(parent);
+        }
+        if (!FileCloner::clone(target.filePath(path), staging.filePath(path), FileCloner::Hardlink)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StagedInstall::commit(QString &previousDir)
+{
+    previousDir.clear();
+    QDir dir;
+
+    // 全新安装：只需一次改名
+    if (!QFileInfo::exists(m_targetDir)) {
+        return dir.rename(m_stagingDir, m_targetDir);
+    }
+
+    // 上次遗留的旧版本还没删完时不能覆盖，这种情况很少，直接删除
+    if (QFileInfo::exists(m_previousDir) && !QDir(m_previousDir).removeRecursively()) {
+        return false;
+    }
+    if (!dir.rename(m_targetDir, m_previousDir)) {
+        return false;
+    }
+    if (!dir.rename(m_stagingDir, m_targetDir)) {
+        dir.rename(m_previousDir, m_targetDir);
+        return false;
+    }
+    previousDir = m_previousDir;
+    return true;
+}
+
+void StagedInstall::discard()
+{
+    QDir(m_stagingDir).removeRecursively();
+}
+
+QString StagedInstall::siblingPath(const char *suffix) const
+{
+    // 隐藏的同级目录：<上级目录>/.<安装目录名><suffix>
+    QFileInfo target(m_targetDir);
+    return target.path() + QLatin1String("/.") + target.fileName() + QLatin1String(suffix);
+}
@@ -0,0 +1,43 @@
+#ifndef STAGEDINSTALL_H
+#define STAGEDINSTALL_H
+
+#include <QString>
+#include <QStringList>
+
+// 分阶段安装：在安装目录旁边的临时目录中准备好完整的新版本，再用两次目录改名替换旧版本，
+// 应用不可用的时间只有这两次 rename，与安装包大小无关；准备过程中失败时旧版本保持不变。
+// 临时目录和旧版本都放在安装目录的上级目录中，保证改名在同一个卷上进行
+class StagedInstall
+{
+public:
+    explicit StagedInstall(const QString &targetDir);
+
+    // 创建空的临时目录；上次在两次改名之间中断时先恢复旧版本。
+    // resume 为 true 时保留上次中断留下的临时目录，在其中继续安装
+    bool prepare(bool resume = false);
+
+    // prepare() 中失败的文件系统调用次数，包括恢复旧版本时失败的改名
+    int failedCalls() const;
+
+    QString stagingDir() const;
+
+    // 把旧版本中保留的文件（相对安装目录的路径）带到临时目录，同一个卷上使用硬链接，不需要复制数据
+    bool carryOver(const QStringList &relativePaths);
+
+    // 用临时目录替换安装目录；旧版本改名为 previousDir 返回，没有旧版本时为空。
+    // 第二次改名失败时把旧版本改回原处
+    bool commit(QString &previousDir);
+
+    // 放弃临时目录
+    void discard();
+
+private:
+    QString siblingPath(const char *suffix) const;
+
+    QString m_targetDir;
+    QString m_stagingDir;
+    QString m_previousDir;
+    int m_failedCalls;
+};
+
+#endif // STAGEDINSTALL_H
@@ -12,7 +12,10 @@ import shutil
 # 添加当前目录到路径，以便导入append_zip模块
 sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
 
-from append_zip import append_zip_to_exe, MAGIC_SIGNATURE
+from append_zip import (append_zip_to_exe, MAGIC_SIGNATURE, TRAILER_SIZE, MANIFEST_MAGIC,
+                        MANIFEST_VERSION, MANIFEST_HEADER, MANIFEST_ENTRY, FRAMED_MANIFEST_VERSION,
+                        FRAMED_PAYLOAD_MAGIC, FRAME_TABLE_HEADER, FRAME_STORED_FLAG, CHECKSUM_MAGIC,
+                        CHECKSUM_BLOCK, tree_hash)
 
 def create_test_zip(zip_path):
     """创建一个测试用的ZIP文件"""
@@ -70,6 +73,132 @@ def read_zip_metadata(exe_path):
     
     return {'magic_found': False}
 
+def read_manifest(exe_path, metadata):
+    """读取ZIP数据之后的安装清单（模拟C++代码的逻辑），旧格式没有清单时返回None"""
+    manifest_size = metadata['metadata_size'] - TRAILER_SIZE
+    if manifest_size <= 0:
+        return None
+    
+    with open(exe_path, 'rb') as f:
+        f.seek(os.path.getsize(exe_path) - metadata['metadata_size'])
+        data = f.read(manifest_size)
+    
+    magic, version, flags, dir_count, entry_count, total_compressed, total_uncompressed = \
+        MANIFEST_HEADER.unpack_from(data, 0)
+    if magic != MANIFEST_MAGIC or version not in (MANIFEST_VERSION, FRAMED_MANIFEST_VERSION):
+        return None
+    
+    pos = MANIFEST_HEADER.size
+    directories = []
+    for _ in range(dir_count):
+        length, = struct.unpack_from('<H', data, pos)
+        directories.append(data[pos + 2:pos + 2 + length].decode('utf-8'))
+        pos += 2 + length
+    
+    entries = []
+    for _ in range(entry_count):
+        header_offset, data_offset, compressed, uncompressed, crc, method, length, content_hash = \
+            MANIFEST_ENTRY.unpack_from(data, pos)
+        pos += MANIFEST_ENTRY.size
+        entries.append({
+            'path': data[pos:pos + length].decode('utf-8'),
+            'header_offset': header_offset,
+            'data_offset': data_offset,
+            'compressed_size': compressed,
+            'uncompressed_size': uncompressed,
+            'crc': crc,
+            'method': method,
+            'hash': content_hash,
+        })
+        pos += length
+    
+    # 分帧格式的帧表紧跟在文件条目之后
+    frame_size, frames = 0, []
+    if version == FRAMED_MANIFEST_VERSION:
+        frame_size, frame_count = FRAME_TABLE_HEADER.unpack_from(data, pos)
+        pos += FRAME_TABLE_HEADER.size
+        frames = list(struct.unpack_from(f'<{frame_count}I', data, pos))
+    
+    return {
+        'version': version,
+        'directories': directories,
+        'entries': entries,
+        'total_compressed': total_compressed,
+        'total_uncompressed': total_uncompressed,
+        'frame_size': frame_size,
+        'frames': frames,
+    }
+
+def verify_checksum(exe_path, metadata):
+    """校验魔术字符串之前的整体校验块（模拟C++代码的逻辑）"""
+    with open(exe_path, 'rb') as f:
+        data = f.read()
+    block_start = len(data) - TRAILER_SIZE - CHECKSUM_BLOCK.size
+    magic, leaf_size, _, covered_size, root = CHECKSUM_BLOCK.unpack_from(data, block_start)
+    if magic != CHECKSUM_MAGIC or metadata['zip_offset'] + covered_size != block_start:
+        return False
+    covered = data[metadata['zip_offset']:metadata['zip_offset'] + covered_size]
+    return tree_hash(covered, leaf_size) == root
+
+def lz4_decompress_block(block):
+    """解码一个 LZ4 块（模拟C++代码的逻辑）"""
+    out = bytearray()
+    pos = 0
+    while pos < len(block):
+        token = block[pos]
+        pos += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                byte = block[pos]
+                pos += 1
+                length += byte
+                if byte != 255:
+                    break
+        out += block[pos:pos + length]
+        pos += length
+        if pos >= len(block):
+            break
+        offset = block[pos] | (block[pos + 1] << 8)
+        pos += 2
+        length = token & 15
+        if length == 15:
+            while True:
+                byte = block[pos]
+                pos += 1
+                length += byte
+                if byte != 255:
+                    break
+        for _ in range(length + 4):
+            out.append(out[-offset])
+    return bytes(out)
+
+def extract_framed_files(exe_path, metadata, manifest):
+    """按帧表解码分帧载荷中的每个文件"""
+    with open(exe_path, 'rb') as f:
+        f.seek(metadata['zip_offset'])
+        payload = f.read(metadata['zip_size'])
+    if payload[:len(FRAMED_PAYLOAD_MAGIC)] != FRAMED_PAYLOAD_MAGIC:
+        return None
+    
+    offsets = []
+    offset = len(FRAMED_PAYLOAD_MAGIC)
+    for frame in manifest['frames']:
+        offsets.append(offset)
+        offset += frame & ~FRAME_STORED_FLAG
+    
+    files = {}
+    frame_size = manifest['frame_size']
+    for entry in manifest['entries']:
+        data = bytearray()
+        frame_count = (entry['uncompressed_size'] + frame_size - 1) // frame_size
+        for frame in range(entry['header_offset'], entry['header_offset'] + frame_count):
+            size = manifest['frames'][frame] & ~FRAME_STORED_FLAG
+            block = payload[offsets[frame]:offsets[frame] + size]
+            data += block if manifest['frames'][frame] & FRAME_STORED_FLAG else lz4_decompress_block(block)
+        files[entry['path']] = bytes(data)
+    return files
+
 def extract_zip_from_exe(exe_path, output_zip_path):
     """从EXE文件中提取ZIP文件（模拟C++代码的逻辑）"""
     metadata = read_zip_metadata(exe_path)
@@ -171,6 +300,47 @@ def test_zip_append_functionality():
             print(f"   ❌ ZIP文件验证失败: {e}")
             return False
         
+        # 步骤6: 验证安装清单
+        print("\n6. 验证安装清单...")
+        manifest = read_manifest(test_exe, metadata)
+        if not manifest:
+            print("   ❌ 未找到安装清单")
+            return False
+        
+        with zipfile.ZipFile(extracted_zip, 'r') as zf:
+            expected = {info.filename: info for info in zf.infolist() if not info.is_dir()}
+            if sorted(e['path'] for e in manifest['entries']) != sorted(expected):
+                print("   ❌ 清单条目与ZIP不一致")
+                return False
+            for entry in manifest['entries']:
+                info = expected[entry['path']]
+                if (entry['crc'] != info.CRC or entry['uncompressed_size'] != info.file_size
+                        or entry['compressed_size'] != info.compress_size):
+                    print(f"   ❌ 条目信息不一致: {entry['path']}")
+                    return False
+        
+        if manifest['directories'] != ['folder']:
+            print(f"   ❌ 目录列表不正确: {manifest['directories']}")
+            return False
+        
+        print(f"   ✅ 安装清单有效: {len(manifest['directories'])} 个目录, "
+              f"{len(manifest['entries'])} 个文件, 共 {manifest['total_uncompressed']} bytes")
+        
+        # 步骤7: 验证整体校验值，篡改任意一个字节后必须校验失败
+        print("\n7. 验证整体校验值...")
+        if not verify_checksum(test_exe, metadata):
+            print("   ❌ 整体校验失败")
+            return False
+        with open(test_exe, 'r+b') as f:
+            f.seek(metadata['zip_offset'] + metadata['zip_size'] // 2)
+            byte = f.read(1)
+            f.seek(-1, os.SEEK_CUR)
+            f.write(bytes([byte[0] ^ 0xff]))
+        if verify_checksum(test_exe, metadata):
+            print("   ❌ 篡改后的安装包没有被发现")
+            return False
+        print("   ✅ 整体校验值有效，篡改可以被发现")
+        
         print("\n🎉 所有测试通过！新的ZIP附加和读取功能工作正常。")
         return True
         
@@ -178,6 +348,60 @@ def test_zip_append_functionality():
         # 清理临时文件
         shutil.rmtree(temp_dir, ignore_errors=True)
 
+def test_framed_payload():
+    """测试分帧LZ4载荷的生成和解码"""
+    print("\n=== 测试分帧LZ4载荷 ===")
+    import random
+    import zipfile
+    
+    temp_dir = tempfile.mkdtemp()
+    
+    try:
+        test_exe = os.path.join(temp_dir, 'test.exe')
+        test_zip = os.path.join(temp_dir, 'test.zip')
+        create_test_exe(test_exe)
+        
+        # 可压缩的文本、不可压缩的随机数据（按原样保存的帧）、空文件和重复文件
+        rng = random.Random(1)
+        contents = {
+            'text.txt': b'The quick brown fox jumps over the lazy dog. ' * 3000,
+            'bin/random.dat': bytes(rng.getrandbits(8) for _ in range(20000)),
+            'bin/empty.dat': b'',
+            'copy/text.txt': b'The quick brown fox jumps over the lazy dog. ' * 3000,
+        }
+        with zipfile.ZipFile(test_zip, 'w', zipfile.ZIP_DEFLATED) as zf:
+            for name, data in contents.items():
+                zf.writestr(name, data)
+        
+        if not append_zip_to_exe(test_exe, test_zip, dedup=True, payload_format='lz4', frame_size=4096):
+            print("   ❌ 分帧载荷附加失败")
+            return False
+        
+        metadata = read_zip_metadata(test_exe)
+        manifest = read_manifest(test_exe, metadata)
+        if not manifest or manifest['version'] != FRAMED_MANIFEST_VERSION:
+            print("   ❌ 未找到分帧格式的安装清单")
+            return False
+        
+        files = extract_framed_files(test_exe, metadata, manifest)
+        if files != contents:
+            print("   ❌ 分帧载荷解码结果与原文件不一致")
+            return False
+        
+        entries = {entry['path']: entry for entry in manifest['entries']}
+        if entries['text.txt']['header_offset'] != entries['copy/text.txt']['header_offset']:
+            print("   ❌ 重复文件没有共用帧")
+            return False
+        if not any(frame & FRAME_STORED_FLAG for frame in manifest['frames']):
+            print("   ❌ 不可压缩的帧没有按原样保存")
+            return False
+        
+        print(f"   ✅ 分帧载荷有效: {len(manifest['frames'])} 帧, 载荷 {metadata['zip_size']} bytes")
+        return True
+        
+    finally:
+        shutil.rmtree(temp_dir, ignore_errors=True)
+
 if __name__ == "__main__":
-    success = test_zip_append_functionality()
+    success = test_zip_append_functionality() and test_framed_payload()
     sys.exit(0 if success else 1)
\ No newline at end of file
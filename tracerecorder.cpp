@@ -0,0 +1,177 @@
+#include "tracerecorder.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QVector>
+
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char *name;   // 记录点的字符串常量，不复制
+    char phase;         // 'B' / 'E' / 'X'
+    qint64 start;
+    qint64 duration;
+    QString detail;
+};
+
+// 每个线程的事件缓冲区，线程结束后仍然保留，直到写出
+struct ThreadBuffer {
+    int tid;
+    QString name;
+    std::vector<TraceEvent> events;
+};
+
+const size_t INITIAL_EVENT_CAPACITY = 4096;
+
+QMutex g_registryMutex;
+QVector<ThreadBuffer *> g_buffers;
+QElapsedTimer g_epoch;
+// start() 时递增，线程据此发现自己的缓冲区属于上一次记录
+QAtomicInteger<int> g_generation(0);
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+thread_local int t_generation = -1;
+
+ThreadBuffer *threadBuffer()
+{
+    int generation = g_generation.loadRelaxed();
+    if (!t_buffer || t_generation != generation) {
+        ThreadBuffer *buffer = new ThreadBuffer;
+        buffer->events.reserve(INITIAL_EVENT_CAPACITY);
+        QMutexLocker locker(&g_registryMutex);
+        buffer->tid = g_buffers.size() + 1;
+        g_buffers.append(buffer);
+        t_buffer = buffer;
+        t_generation = generation;
+    }
+    return t_buffer;
+}
+
+void appendJsonString(QByteArray &out, const QString &text)
+{
+    // 先在 QString 上转义，再整体转成 UTF-8，代理对不会被拆开
+    QString escaped;
+    escaped.reserve(text.size());
+    for (QChar c : text) {
+        if (c == QLatin1Char('"') || c == QLatin1Char('\\')) {
+            escaped.append(QLatin1Char('\\'));
+            escaped.append(c);
+        } else if (c.unicode() < 0x20) {
+            escaped.append(QStringLiteral("\\u%1").arg(int(c.unicode()), 4, 16, QLatin1Char('0')));
+        } else {
+            escaped.append(c);
+        }
+    }
+    out.append('"');
+    out.append(escaped.toUtf8());
+    out.append('"');
+}
+
+} // namespace
+
+QAtomicInteger<int> TraceRecorder::s_enabled(0);
+
+void TraceRecorder::start()
+{
+    QMutexLocker locker(&g_registryMutex);
+    qDeleteAll(g_buffers);
+    g_buffers.clear();
+    g_generation.fetchAndAddRelaxed(1);
+    g_epoch.start();
+    s_enabled.storeRelaxed(1);
+}
+
+bool TraceRecorder::save(const QString &path)
+{
+    s_enabled.storeRelaxed(0);
+    QMutexLocker locker(&g_registryMutex);
+
+    // 事件可能很多，直接拼接 JSON 文本，不经过 QJsonDocument
+    QByteArray out("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) {
+            out.append(",\n");
+        }
+        first = false;
+    };
+    for (const ThreadBuffer *buffer : std::as_const(g_buffers)) {
+        QByteArray tid = QByteArray::number(buffer->tid);
+        if (!buffer->name.isEmpty()) {
+            separator();
+            out.append("{\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"thread_name\",\"args\":{\"name\":");
+            appendJsonString(out, buffer->name);
+            out.append("}}");
+        }
+        for (const TraceEvent &event : buffer->events) {
+            separator();
+            // 时间以微秒为单位，保留到纳秒
+            out.append("{\"ph\":\"");
+            out.append(event.phase);
+            out.append("\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"");
+            out.append(event.name);
+            out.append("\",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3));
+            if (event.phase == 'X') {
+                out.append(",\"dur\":" + QByteArray::number(event.duration / 1000.0, 'f', 3));
+            }
+            if (!event.detail.isEmpty()) {
+                out.append(",\"args\":{\"file\":");
+                appendJsonString(out, event.detail);
+                out.append('}');
+            }
+            out.append('}');
+        }
+    }
+    out.append("\n]}\n");
+
+    // 写出后释放缓冲区；仍在运行的线程下次记录时会发现代数变化，不会再用旧指针
+    qDeleteAll(g_buffers);
+    g_buffers.clear();
+    g_generation.fetchAndAddRelaxed(1);
+    locker.unlock();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(out);
+    return file.commit();
+}
+
+void TraceRecorder::setThreadName(const QString &name)
+{
+    if (isEnabled()) {
+        threadBuffer()->name = name;
+    }
+}
+
+void TraceRecorder::begin(const char *name)
+{
+    if (isEnabled()) {
+        threadBuffer()->events.push_back({ name, 'B', now(), 0, QString() });
+    }
+}
+
+void TraceRecorder::end(const char *name)
+{
+    if (isEnabled()) {
+        threadBuffer()->events.push_back({ name, 'E', now(), 0, QString() });
+    }
+}
+
+void TraceRecorder::complete(const char *name, qint64 startNs, qint64 endNs, const QString &detail)
+{
+    if (isEnabled()) {
+        threadBuffer()->events.push_back({ name, 'X', startNs, endNs - startNs, detail });
+    }
+}
+
+qint64 TraceRecorder::now()
+{
+    return g_epoch.nsecsElapsed();
+}
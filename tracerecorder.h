@@ -0,0 +1,58 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QAtomicInteger>
+#include <QString>
+
+// 安装过程的时间线，保存为 Chrome / Perfetto 的 trace event 格式（chrome://tracing 或 ui.perfetto.dev 打开），
+// 用来查看各线程的空闲、等待和拖尾的大文件。
+// 每个线程把事件追加到自己的缓冲区，记录时不加锁；未启用时每个记录点只有一次原子读
+class TraceRecorder
+{
+public:
+    // 清空以前的记录并开始记录
+    static void start();
+    static bool isEnabled() { return s_enabled.loadRelaxed() != 0; }
+
+    // 停止记录并写出全部线程的事件，应在记录事件的工作线程都结束之后调用
+    static bool save(const QString &path);
+
+    // 时间线上显示的线程名，在线程开始时调用一次
+    static void setThreadName(const QString &name);
+
+    // 开始/结束一个阶段，begin 和 end 必须在同一个线程中成对调用
+    static void begin(const char *name);
+    static void end(const char *name);
+
+    // 记录一段已经结束的区间，时间来自 now()
+    static void complete(const char *name, qint64 startNs, qint64 endNs, const QString &detail = QString());
+
+    // 自 start() 起的纳秒数
+    static qint64 now();
+
+    // 作用域内的一段区间；未启用时不计时
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name, const QString &detail = QString())
+            : m_name(isEnabled() ? name : nullptr), m_detail(m_name ? detail : QString()), m_start(m_name ? now() : 0)
+        {
+        }
+        ~Scope()
+        {
+            if (m_name) {
+                complete(m_name, m_start, now(), m_detail);
+            }
+        }
+
+    private:
+        const char *m_name;
+        QString m_detail;
+        qint64 m_start;
+    };
+
+private:
+    static QAtomicInteger<int> s_enabled;
+};
+
+#endif // TRACERECORDER_H
@@ -0,0 +1,352 @@
+#include "upgradeplanner.h"
+#include "backgroundremover.h"
+#include "crc32.h"
+#include "installjournal.h"
+#include "installmetrics.h"
+#include "memorybudget.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace {
+
+// 记录文件：头部之后每个文件一条定长记录，后跟内容哈希和 UTF-8 路径
+const char RECORD_MAGIC[] = "AUSICREC";
+const int RECORD_MAGIC_SIZE = 8;
+const quint32 RECORD_VERSION = 1;
+const int RECORD_HEADER_SIZE = RECORD_MAGIC_SIZE + 4 + 4;
+const int RECORD_ENTRY_SIZE = 8 + 8 + 4 + 2 + 1;
+
+// 没有可信记录时按块读取已安装文件计算 CRC
+const qint64 CRC_BLOCK_SIZE = 1024 * 1024;
+
+inline quint16 readU16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+inline quint32 readU32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+inline quint64 readU64(const uchar *p) { return qFromLittleEndian<quint64>(p); }
+
+qint64 modifiedTime(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+// 安装程序自己在安装目录中留下的文件：既不带到新版本，也不当作旧文件删除
+bool isInstallerFile(const QString &path, const char *recordFileName)
+{
+    return path == QLatin1String(recordFileName)
+           || path == QLatin1String(InstallMetrics::REPORT_FILE_NAME)
+           || path == QLatin1String(InstallJournal::JOURNAL_FILE_NAME)
+           || path.startsWith(QLatin1String(BackgroundRemover::TRASH_DIR_NAME) + QLatin1Char('/'));
+}
+
+} // namespace
+
+const char UpgradePlanner::RECORD_FILE_NAME[] = ".ausic_install";
+
+UpgradePlanner::UpgradePlanner(const QString &targetDir)
+    : m_targetDir(targetDir)
+    , m_hasRecord(false)
+    , m_unchanged(0)
+{
+}
+
+void UpgradePlanner::plan(const QVector<ZipEntry> &entries)
+{
+    m_pending.clear();
+    m_obsolete.clear();
+    m_packageDirs.clear();
+    m_unchanged = 0;
+    m_hasRecord = loadRecord();
+
+    QDir targetDir(m_targetDir);
+    QSet<QString> packageFiles;
+    for (const ZipEntry &entry : entries) {
+        if (entry.isDir) {
+            m_packageDirs.insert(entry.filePath);
+            m_pending.append(entry);
+
+            // 原来是同名文件的位置现在是目录
+            QFileInfo info(targetDir.filePath(entry.filePath));
+            if (info.exists() && !info.isDir()) {
+                m_obsolete.append(entry.filePath);
+            }
+            continue;
+        }
+
+        packageFiles.insert(entry.filePath);
+        for (QString parent = QFileInfo(entry.filePath).path();
+             !parent.isEmpty() && parent != QLatin1String(".");
+             parent = QFileInfo(parent).path()) {
+            m_packageDirs.insert(parent);
+        }
+
+        if (isUnchanged(entry)) {
+            m_unchanged++;
+            continue;
+        }
+
+        // 原来是同名目录的位置现在是文件
+        if (QFileInfo(targetDir.filePath(entry.filePath)).isDir()) {
+            m_obsolete.append(entry.filePath);
+        }
+        m_pending.append(entry);
+    }
+
+    collectObsolete(packageFiles);
+}
+
+const QVector<ZipEntry> &UpgradePlanner::pendingEntries() const
+{
+    return m_pending;
+}
+
+const QStringList &UpgradePlanner::obsoletePaths() const
+{
+    return m_obsolete;
+}
+
+int UpgradePlanner::unchangedCount() const
+{
+    return m_unchanged;
+}
+
+void UpgradePlanner::removeObsolete(BackgroundRemover *remover)
+{
+    QDir targetDir(m_targetDir);
+    for (const QString &path : m_obsolete) {
+        QString fullPath = targetDir.filePath(path);
+        QFileInfo info(fullPath);
+
+        // 个别文件删除失败时继续安装
+        if (!remover || !remover->moveAside(path)) {
+            if (info.isDir() && !info.isSymLink()) {
+                QDir(fullPath).removeRecursively();
+            } else {
+                QFile::remove(fullPath);
+            }
+        }
+
+        // 顺带删除因此变空、且不属于新安装包的上级目录
+        for (QString parent = QFileInfo(path).path();
+             !parent.isEmpty() && parent != QLatin1String(".") && !m_packageDirs.contains(parent);
+             parent = QFileInfo(parent).path()) {
+            if (!targetDir.rmdir(parent)) {
+                break;
+            }
+        }
+    }
+}
+
+QStringList UpgradePlanner::retainedFiles() const
+{
+    QSet<QString> written;
+    for (const ZipEntry &entry : m_pending) {
+        if (!entry.isDir) {
+            written.insert(entry.filePath);
+        }
+    }
+    const QSet<QString> obsolete(m_obsolete.cbegin(), m_obsolete.cend());
+
+    QDir targetDir(m_targetDir);
+    QStringList retained;
+    QDirIterator it(m_targetDir, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = targetDir.relativeFilePath(it.next());
+        if (written.contains(path) || isInstallerFile(path, RECORD_FILE_NAME)) {
+            continue;
+        }
+
+        // 旧文件本身，或位于要删除的目录中
+        bool removed = false;
+        for (QString parent = path; !parent.isEmpty() && parent != QLatin1String(".");
+             parent = QFileInfo(parent).path()) {
+            if (obsolete.contains(parent)) {
+                removed = true;
+                break;
+            }
+        }
+        if (!removed) {
+            retained.append(path);
+        }
+    }
+    return retained;
+}
+
+bool UpgradePlanner::saveRecord(const QVector<ZipEntry> &entries, const QString &installDir)
+{
+    QDir targetDir(installDir.isEmpty() ? m_targetDir : installDir);
+    QByteArray data(RECORD_HEADER_SIZE, '\0');
+    memcpy(data.data(), RECORD_MAGIC, RECORD_MAGIC_SIZE);
+    qToLittleEndian<quint32>(RECORD_VERSION, data.data() + RECORD_MAGIC_SIZE);
+
+    quint32 count = 0;
+    for (const ZipEntry &entry : entries) {
+        if (entry.isDir) {
+            continue;
+        }
+        QFileInfo info(targetDir.filePath(entry.filePath));
+        if (!info.isFile()) {
+            continue;
+        }
+
+        QByteArray path = entry.filePath.toUtf8();
+        QByteArray record(RECORD_ENTRY_SIZE, '\0');
+        char *p = record.data();
+        qToLittleEndian<quint64>(quint64(info.size()), p);
+        qToLittleEndian<quint64>(quint64(modifiedTime(info)), p + 8);
+        qToLittleEndian<quint32>(entry.crc32, p + 16);
+        qToLittleEndian<quint16>(quint16(path.size()), p + 20);
+        p[22] = char(entry.contentHash.size());
+        data.append(record);
+        data.append(entry.contentHash);
+        data.append(path);
+        count++;
+    }
+    qToLittleEndian<quint32>(count, data.data() + RECORD_MAGIC_SIZE + 4);
+
+    QSaveFile file(targetDir.filePath(QLatin1String(RECORD_FILE_NAME)));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        return false;
+    }
+    return file.commit();
+}
+
+bool UpgradePlanner::loadRecord()
+{
+    m_record.clear();
+
+    QFile file(QDir(m_targetDir).filePath(QLatin1String(RECORD_FILE_NAME)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    qint64 size = data.size();
+    if (size < RECORD_HEADER_SIZE || memcmp(p, RECORD_MAGIC, RECORD_MAGIC_SIZE) != 0
+        || readU32(p + RECORD_MAGIC_SIZE) != RECORD_VERSION) {
+        return false;
+    }
+
+    quint32 count = readU32(p + RECORD_MAGIC_SIZE + 4);
+    qint64 pos = RECORD_HEADER_SIZE;
+    for (quint32 i = 0; i < count; i++) {
+        if (pos + RECORD_ENTRY_SIZE > size) {
+            m_record.clear();
+            return false;
+        }
+        const uchar *record = p + pos;
+        quint16 pathLength = readU16(record + 20);
+        int hashLength = record[22];
+        if (pos + RECORD_ENTRY_SIZE + hashLength + pathLength > size) {
+            m_record.clear();
+            return false;
+        }
+
+        InstalledFile installed;
+        installed.size = qint64(readU64(record));
+        installed.modified = qint64(readU64(record + 8));
+        installed.crc32 = readU32(record + 16);
+        installed.contentHash = QByteArray(reinterpret_cast<const char *>(record + RECORD_ENTRY_SIZE), hashLength);
+        QString path = QString::fromUtf8(reinterpret_cast<const char *>(record + RECORD_ENTRY_SIZE + hashLength),
+                                         pathLength);
+        m_record.insert(path, installed);
+        pos += RECORD_ENTRY_SIZE + hashLength + pathLength;
+    }
+
+    return true;
+}
+
+bool UpgradePlanner::isUnchanged(const ZipEntry &entry) const
+{
+    QFileInfo info(QDir(m_targetDir).filePath(entry.filePath));
+    if (!info.isFile() || info.size() != entry.uncompressedSize) {
+        return false;
+    }
+
+    // 记录与磁盘上的文件一致，只需比较安装包提供的校验值
+    auto it = m_record.constFind(entry.filePath);
+    if (it != m_record.constEnd() && it->size == info.size() && it->modified == modifiedTime(info)) {
+        if (!it->contentHash.isEmpty() && !entry.contentHash.isEmpty()) {
+            return it->contentHash == entry.contentHash;
+        }
+        return it->crc32 == entry.crc32;
+    }
+
+    // 没有记录或文件被改动过：读取文件内容比较 CRC
+    quint32 crc = 0;
+    return fileCrc32(info.filePath(), crc) && crc == entry.crc32;
+}
+
+void UpgradePlanner::collectObsolete(const QSet<QString> &packageFiles)
+{
+    QDir targetDir(m_targetDir);
+
+    if (m_hasRecord) {
+        // 只删除上次安装过、而新安装包里已经没有的文件，用户自己的文件保留
+        for (auto it = m_record.constBegin(); it != m_record.constEnd(); ++it) {
+            if (!packageFiles.contains(it.key()) && !m_packageDirs.contains(it.key())
+                && QFileInfo::exists(targetDir.filePath(it.key()))) {
+                m_obsolete.append(it.key());
+            }
+        }
+        return;
+    }
+
+    // 旧版本安装程序没有留下记录：和以前一样清理安装包之外的所有文件，只是保留未变化的文件；
+    // 上次没删完的回收目录由 BackgroundRemover 处理
+    QDirIterator it(m_targetDir, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = targetDir.relativeFilePath(it.next());
+        if (!packageFiles.contains(path) && !m_packageDirs.contains(path) && !isInstallerFile(path, RECORD_FILE_NAME)) {
+            m_obsolete.append(path);
+        }
+    }
+}
+
+bool UpgradePlanner::fileCrc32(const QString &path, quint32 &crc)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = file.size();
+    crc = 0;
+    if (size == 0) {
+        return true;
+    }
+
+    // 优先整体映射，映射失败时按块读取。大文件分块计算，算过的部分随即移出工作集，
+    // 校验多 GB 的文件时内存占用也不会随文件大小增长
+    if (uchar *map = file.map(0, size)) {
+        for (qint64 pos = 0; pos < size; pos += CRC_BLOCK_SIZE) {
+            qint64 length = qMin(CRC_BLOCK_SIZE, size - pos);
+            crc = Crc32::update(crc, map + pos, length);
+            if (size > CRC_BLOCK_SIZE) {
+                MemoryBudget::releasePages(map + pos, length);
+            }
+        }
+        file.unmap(map);
+        return true;
+    }
+
+    QByteArray buffer(int(qMin(size, CRC_BLOCK_SIZE)), Qt::Uninitialized);
+    qint64 remaining = size;
+    while (remaining > 0) {
+        qint64 length = file.read(buffer.data(), qMin(remaining, qint64(buffer.size())));
+        if (length <= 0) {
+            return false;
+        }
+        crc = Crc32::update(crc, reinterpret_cast<const uchar *>(buffer.constData()), length);
+        remaining -= length;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef UPGRADEPLANNER_H
+#define UPGRADEPLANNER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "zipindex.h"
+
+class BackgroundRemover;
+
+// 升级安装：比较安装目录与安装包，只写入新增或变化的文件，只删除不再属于安装包的文件
+// 上次安装的结果记录在安装目录的 RECORD_FILE_NAME 中（大小、修改时间、CRC、内容哈希），
+// 记录与磁盘一致时不需要读取已安装的文件
+class UpgradePlanner
+{
+public:
+    explicit UpgradePlanner(const QString &targetDir);
+
+    void plan(const QVector<ZipEntry> &entries);
+
+    // 全部目录条目加上需要写入的文件条目
+    const QVector<ZipEntry> &pendingEntries() const;
+    const QStringList &obsoletePaths() const;
+    int unchangedCount() const;
+
+    // 有 remover 时旧文件只改名移入回收目录，由它在后台删除；移动失败的文件直接删除
+    void removeObsolete(BackgroundRemover *remover = nullptr);
+
+    // 安装目录中不用重新写入、也不删除的文件：未变化的文件和用户自己的文件
+    QStringList retainedFiles() const;
+
+    // 安装完成后记录本次安装的文件，供下次升级比较；installDir 为空时写入安装目录
+    bool saveRecord(const QVector<ZipEntry> &entries, const QString &installDir = QString());
+
+    // 整个文件的 CRC-32，优先映射文件计算
+    static bool fileCrc32(const QString &path, quint32 &crc);
+
+    static const char RECORD_FILE_NAME[];
+
+private:
+    struct InstalledFile {
+        qint64 size;
+        qint64 modified;    // 修改时间，自 1970 年起的毫秒数
+        quint32 crc32;
+        QByteArray contentHash;
+    };
+
+    bool loadRecord();
+    bool isUnchanged(const ZipEntry &entry) const;
+    void collectObsolete(const QSet<QString> &packageFiles);
+
+    QString m_targetDir;
+    QHash<QString, InstalledFile> m_record;
+    bool m_hasRecord;
+    QSet<QString> m_packageDirs;
+    QVector<ZipEntry> m_pending;
+    QStringList m_obsolete;
+    int m_unchanged;
+};
+
+#endif // UPGRADEPLANNER_H
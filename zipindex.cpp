@@ -0,0 +1,487 @@
+#include "zipindex.h"
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QDir>
+#include <QStringList>
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+const quint32 ZIP64_END_OF_CENTRAL_DIR_SIGNATURE = 0x06064b50;
+const quint32 ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+
+const int LOCAL_HEADER_SIZE = 30;
+const int CENTRAL_HEADER_SIZE = 46;
+const int END_OF_CENTRAL_DIR_SIZE = 22;
+const int ZIP64_END_OF_CENTRAL_DIR_SIZE = 56;
+const int ZIP64_LOCATOR_SIZE = 20;
+const int MAX_COMMENT_SIZE = 65535;
+
+const quint16 FLAG_ENCRYPTED = 0x0001;
+const quint16 FLAG_UTF8_NAMES = 0x0800;
+const quint16 ZIP64_EXTRA_ID = 0x0001;
+
+// 安装清单：头部之后是目录列表（长度 + UTF-8 路径），然后是文件条目（定长记录 + 路径）
+const char MANIFEST_MAGIC[] = "AUSICMAN";
+const int MANIFEST_MAGIC_SIZE = 8;
+const int MANIFEST_HEADER_SIZE = 36;
+const int MANIFEST_ENTRY_SIZE = 56;
+const int CONTENT_HASH_SIZE = 16;
+
+// 分帧格式的帧表位于文件条目之后：帧大小、帧数，然后是每帧压缩后的大小
+const int FRAME_TABLE_HEADER_SIZE = 8;
+
+inline quint16 readU16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+inline quint32 readU32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+inline quint64 readU64(const uchar *p) { return qFromLittleEndian<quint64>(p); }
+
+QByteArray readAt(QIODevice *archive, qint64 offset, qint64 size)
+{
+    if (offset < 0 || size < 0 || offset + size > archive->size() || !archive->seek(offset)) {
+        return QByteArray();
+    }
+    return archive->read(size);
+}
+
+} // namespace
+
+const char ZipIndex::FRAMED_PAYLOAD_MAGIC[] = "AUSICLZ4";
+
+ZipIndex::ZipIndex()
+{
+}
+
+const QVector<ZipEntry> &ZipIndex::entries() const
+{
+    return m_entries;
+}
+
+bool ZipIndex::isFramed() const
+{
+    return m_frames.frameSize > 0;
+}
+
+const FrameTable &ZipIndex::frames() const
+{
+    return m_frames;
+}
+
+bool ZipIndex::load(QIODevice *archive)
+{
+    m_entries.clear();
+    m_frames = FrameTable();
+
+    if (!archive || !archive->isOpen()) {
+        return false;
+    }
+
+    qint64 centralDirOffset = 0;
+    qint64 centralDirSize = 0;
+    qint64 totalEntries = 0;
+    if (!readEndOfCentralDirectory(archive, centralDirOffset, centralDirSize, totalEntries)) {
+        return false;
+    }
+
+    if (!readCentralDirectory(archive, centralDirOffset, centralDirSize, totalEntries)) {
+        m_entries.clear();
+        return false;
+    }
+
+    if (!resolveDataOffsets(archive)) {
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool ZipIndex::loadManifest(const QByteArray &manifest, qint64 archiveSize)
+{
+    m_entries.clear();
+    m_frames = FrameTable();
+
+    const uchar *data = reinterpret_cast<const uchar *>(manifest.constData());
+    qint64 size = manifest.size();
+    if (size < MANIFEST_HEADER_SIZE || memcmp(data, MANIFEST_MAGIC, MANIFEST_MAGIC_SIZE) != 0) {
+        return false;
+    }
+    quint16 version = readU16(data + 8);
+    if (version != MANIFEST_VERSION && version != FRAMED_MANIFEST_VERSION) {
+        return false;
+    }
+    bool framed = version == FRAMED_MANIFEST_VERSION;
+
+    qint64 directoryCount = readU32(data + 12);
+    qint64 entryCount = readU32(data + 16);
+    if (directoryCount * 2 + entryCount * MANIFEST_ENTRY_SIZE > size - MANIFEST_HEADER_SIZE) {
+        return false;
+    }
+    m_entries.reserve(int(directoryCount + entryCount));
+
+    qint64 pos = MANIFEST_HEADER_SIZE;
+    for (qint64 i = 0; i < directoryCount; i++) {
+        if (pos + 2 > size) {
+            m_entries.clear();
+            return false;
+        }
+        quint16 nameLength = readU16(data + pos);
+        if (pos + 2 + nameLength > size) {
+            m_entries.clear();
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.filePath = QString::fromUtf8(reinterpret_cast<const char *>(data + pos + 2), nameLength);
+        entry.isDir = true;
+        entry.method = METHOD_STORED;
+        entry.crc32 = 0;
+        entry.compressedSize = 0;
+        entry.uncompressedSize = 0;
+        entry.localHeaderOffset = -1;
+        entry.dataOffset = -1;
+        entry.firstFrame = -1;
+        entry.index = m_entries.size();
+        m_entries.append(entry);
+        pos += 2 + nameLength;
+    }
+
+    for (qint64 i = 0; i < entryCount; i++) {
+        if (pos + MANIFEST_ENTRY_SIZE > size) {
+            m_entries.clear();
+            return false;
+        }
+        const uchar *record = data + pos;
+        quint16 nameLength = readU16(record + 38);
+        if (pos + MANIFEST_ENTRY_SIZE + nameLength > size) {
+            m_entries.clear();
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.localHeaderOffset = qint64(readU64(record));
+        entry.dataOffset = qint64(readU64(record + 8));
+        entry.compressedSize = qint64(readU64(record + 16));
+        entry.uncompressedSize = qint64(readU64(record + 24));
+        entry.crc32 = readU32(record + 32);
+        entry.method = readU16(record + 36);
+        entry.contentHash = QByteArray(reinterpret_cast<const char *>(record + 40), CONTENT_HASH_SIZE);
+        entry.filePath = QString::fromUtf8(reinterpret_cast<const char *>(record + MANIFEST_ENTRY_SIZE), nameLength);
+        entry.isDir = false;
+        entry.firstFrame = -1;
+
+        // 分帧格式中本地头偏移字段记录的是第一帧的序号
+        if (framed) {
+            entry.firstFrame = entry.localHeaderOffset <= INT_MAX ? int(entry.localHeaderOffset) : -1;
+            entry.localHeaderOffset = -1;
+        }
+
+        bool headerValid = framed ? entry.firstFrame >= 0 && entry.method == METHOD_LZ4_FRAMES
+                                  : entry.localHeaderOffset >= 0
+                                        && entry.dataOffset >= entry.localHeaderOffset + LOCAL_HEADER_SIZE;
+        if (!headerValid || entry.dataOffset < 0 || entry.compressedSize < 0 || entry.uncompressedSize < 0
+            || entry.compressedSize > archiveSize - entry.dataOffset) {
+            m_entries.clear();
+            return false;
+        }
+
+        entry.index = m_entries.size();
+        m_entries.append(entry);
+        pos += MANIFEST_ENTRY_SIZE + nameLength;
+    }
+
+    if (framed && !readFrameTable(data + pos, size - pos, archiveSize)) {
+        m_entries.clear();
+        m_frames = FrameTable();
+        return false;
+    }
+
+    return true;
+}
+
+bool ZipIndex::readFrameTable(const uchar *data, qint64 size, qint64 archiveSize)
+{
+    if (size < FRAME_TABLE_HEADER_SIZE) {
+        return false;
+    }
+    qint64 frameSize = readU32(data);
+    qint64 frameCount = readU32(data + 4);
+    if (frameSize <= 0 || frameSize > MAX_FRAME_SIZE || frameCount * 4 > size - FRAME_TABLE_HEADER_SIZE) {
+        return false;
+    }
+
+    // 各帧在载荷头之后依次紧密排列，偏移由压缩大小累加得到
+    m_frames.frameSize = int(frameSize);
+    m_frames.sizes.resize(int(frameCount));
+    m_frames.offsets.resize(int(frameCount));
+    qint64 offset = FRAMED_PAYLOAD_HEADER_SIZE;
+    for (int i = 0; i < frameCount; i++) {
+        quint32 frame = readU32(data + FRAME_TABLE_HEADER_SIZE + i * 4);
+        qint64 compressed = frame & ~FrameTable::STORED_FLAG;
+        if (compressed > archiveSize - offset || compressed > frameSize) {
+            return false;
+        }
+        m_frames.sizes[i] = frame;
+        m_frames.offsets[i] = offset;
+        offset += compressed;
+    }
+
+    for (const ZipEntry &entry : std::as_const(m_entries)) {
+        if (entry.isDir) {
+            continue;
+        }
+        qint64 count = m_frames.frameCount(entry.uncompressedSize);
+        if (entry.firstFrame + count > frameCount) {
+            return false;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        qint64 compressed = 0;
+        for (int i = entry.firstFrame; i < entry.firstFrame + count; i++) {
+            compressed += m_frames.compressedSize(i);
+        }
+        if (entry.dataOffset != m_frames.offsets.at(entry.firstFrame) || entry.compressedSize != compressed) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ZipIndex::readEndOfCentralDirectory(QIODevice *archive, qint64 &centralDirOffset,
+                                         qint64 &centralDirSize, qint64 &totalEntries)
+{
+    qint64 archiveSize = archive->size();
+    if (archiveSize < END_OF_CENTRAL_DIR_SIZE) {
+        return false;
+    }
+
+    // 结束记录位于末尾，后面最多跟 64KB 注释
+    qint64 tailSize = qMin<qint64>(archiveSize, END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE);
+    qint64 tailStart = archiveSize - tailSize;
+    QByteArray tail = readAt(archive, tailStart, tailSize);
+    if (tail.size() != tailSize) {
+        return false;
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(tail.constData());
+    qint64 recordPos = -1;
+    for (qint64 i = tailSize - END_OF_CENTRAL_DIR_SIZE; i >= 0; i--) {
+        if (readU32(data + i) == END_OF_CENTRAL_DIR_SIGNATURE) {
+            quint16 commentLength = readU16(data + i + 20);
+            if (i + END_OF_CENTRAL_DIR_SIZE + commentLength <= tailSize) {
+                recordPos = i;
+                break;
+            }
+        }
+    }
+    if (recordPos < 0) {
+        return false;
+    }
+
+    const uchar *record = data + recordPos;
+    totalEntries = readU16(record + 10);
+    centralDirSize = readU32(record + 12);
+    centralDirOffset = readU32(record + 16);
+
+    // 任一字段溢出时改读 ZIP64 结束记录
+    bool needsZip64 = totalEntries == 0xffff || centralDirSize == 0xffffffffLL
+                      || centralDirOffset == 0xffffffffLL;
+    qint64 absoluteRecordPos = tailStart + recordPos;
+    if (needsZip64 && absoluteRecordPos >= ZIP64_LOCATOR_SIZE) {
+        QByteArray locator = readAt(archive, absoluteRecordPos - ZIP64_LOCATOR_SIZE, ZIP64_LOCATOR_SIZE);
+        const uchar *loc = reinterpret_cast<const uchar *>(locator.constData());
+        if (locator.size() != ZIP64_LOCATOR_SIZE || readU32(loc) != ZIP64_LOCATOR_SIGNATURE) {
+            return false;
+        }
+
+        qint64 zip64RecordPos = qint64(readU64(loc + 8));
+        QByteArray zip64Record = readAt(archive, zip64RecordPos, ZIP64_END_OF_CENTRAL_DIR_SIZE);
+        const uchar *rec = reinterpret_cast<const uchar *>(zip64Record.constData());
+        if (zip64Record.size() != ZIP64_END_OF_CENTRAL_DIR_SIZE
+            || readU32(rec) != ZIP64_END_OF_CENTRAL_DIR_SIGNATURE) {
+            return false;
+        }
+
+        totalEntries = qint64(readU64(rec + 32));
+        centralDirSize = qint64(readU64(rec + 40));
+        centralDirOffset = qint64(readU64(rec + 48));
+    }
+
+    if (centralDirOffset < 0 || centralDirSize <= 0 || totalEntries <= 0
+        || centralDirOffset + centralDirSize > archiveSize) {
+        return false;
+    }
+
+    return true;
+}
+
+bool ZipIndex::readCentralDirectory(QIODevice *archive, qint64 centralDirOffset,
+                                    qint64 centralDirSize, qint64 totalEntries)
+{
+    QByteArray directory = readAt(archive, centralDirOffset, centralDirSize);
+    if (directory.size() != centralDirSize) {
+        return false;
+    }
+
+    // 每个条目至少占用一个中央目录头，防止伪造的条目数导致过量预分配
+    if (totalEntries > centralDirSize / CENTRAL_HEADER_SIZE) {
+        return false;
+    }
+    m_entries.reserve(int(totalEntries));
+
+    const uchar *data = reinterpret_cast<const uchar *>(directory.constData());
+    qint64 pos = 0;
+    for (qint64 i = 0; i < totalEntries; i++) {
+        if (pos + CENTRAL_HEADER_SIZE > centralDirSize) {
+            return false;
+        }
+
+        const uchar *header = data + pos;
+        if (readU32(header) != CENTRAL_HEADER_SIGNATURE) {
+            return false;
+        }
+
+        quint16 flags = readU16(header + 8);
+        quint16 nameLength = readU16(header + 28);
+        quint16 extraLength = readU16(header + 30);
+        quint16 commentLength = readU16(header + 32);
+        quint32 externalAttributes = readU32(header + 38);
+        quint8 hostSystem = header[5];
+
+        qint64 recordSize = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (pos + recordSize > centralDirSize) {
+            return false;
+        }
+
+        // 不支持加密条目
+        if (flags & FLAG_ENCRYPTED) {
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.method = readU16(header + 10);
+        entry.crc32 = readU32(header + 16);
+        entry.compressedSize = readU32(header + 20);
+        entry.uncompressedSize = readU32(header + 24);
+        entry.localHeaderOffset = readU32(header + 42);
+        entry.dataOffset = -1;
+        entry.firstFrame = -1;
+
+        // ZIP64 扩展字段：只包含主记录中溢出的字段，顺序固定
+        const uchar *extra = header + CENTRAL_HEADER_SIZE + nameLength;
+        const uchar *extraEnd = extra + extraLength;
+        while (extra + 4 <= extraEnd) {
+            quint16 id = readU16(extra);
+            quint16 size = readU16(extra + 2);
+            const uchar *field = extra + 4;
+            const uchar *fieldEnd = field + size;
+            if (fieldEnd > extraEnd) {
+                break;
+            }
+            if (id == ZIP64_EXTRA_ID) {
+                if (entry.uncompressedSize == 0xffffffffLL && field + 8 <= fieldEnd) {
+                    entry.uncompressedSize = qint64(readU64(field));
+                    field += 8;
+                }
+                if (entry.compressedSize == 0xffffffffLL && field + 8 <= fieldEnd) {
+                    entry.compressedSize = qint64(readU64(field));
+                    field += 8;
+                }
+                if (entry.localHeaderOffset == 0xffffffffLL && field + 8 <= fieldEnd) {
+                    entry.localHeaderOffset = qint64(readU64(field));
+                }
+            }
+            extra = fieldEnd;
+        }
+
+        const char *name = reinterpret_cast<const char *>(header + CENTRAL_HEADER_SIZE);
+        QString filePath = (flags & FLAG_UTF8_NAMES)
+                               ? QString::fromUtf8(name, nameLength)
+                               : QString::fromLocal8Bit(name, nameLength);
+        filePath = QDir::fromNativeSeparators(filePath);
+
+        // 目录：名称以 '/' 结尾，或外部属性标记为目录（DOS 属性 0x10 / Unix S_IFDIR）
+        bool isDir = filePath.endsWith(QLatin1Char('/'));
+        if (hostSystem == 0 && (externalAttributes & 0x10)) {
+            isDir = true;
+        } else if (hostSystem == 3 && ((externalAttributes >> 16) & 0170000) == 0040000) {
+            isDir = true;
+        }
+
+        // 去掉开头的 "/" 或 "./" 以及结尾的 "/"
+        while (filePath.startsWith(QLatin1String("./")) || filePath.startsWith(QLatin1Char('/'))) {
+            filePath.remove(0, filePath.startsWith(QLatin1Char('/')) ? 1 : 2);
+        }
+        while (filePath.endsWith(QLatin1Char('/'))) {
+            filePath.chop(1);
+        }
+
+        entry.filePath = filePath;
+        entry.isDir = isDir;
+
+        if (entry.compressedSize < 0 || entry.uncompressedSize < 0 || entry.localHeaderOffset < 0) {
+            return false;
+        }
+
+        entry.index = m_entries.size();
+        m_entries.append(entry);
+        pos += recordSize;
+    }
+
+    return true;
+}
+
+bool ZipIndex::resolveDataOffsets(QIODevice *archive)
+{
+    qint64 archiveSize = archive->size();
+
+    for (ZipEntry &entry : m_entries) {
+        QByteArray header = readAt(archive, entry.localHeaderOffset, LOCAL_HEADER_SIZE);
+        const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+        if (header.size() != LOCAL_HEADER_SIZE || readU32(data) != LOCAL_HEADER_SIGNATURE) {
+            return false;
+        }
+
+        // 本地头的扩展字段长度可能和中央目录不同，必须以本地头为准
+        quint16 nameLength = readU16(data + 26);
+        quint16 extraLength = readU16(data + 28);
+        entry.dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + nameLength + extraLength;
+
+        if (entry.dataOffset + entry.compressedSize > archiveSize) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ZipIndex::isSafePath(const QString &path)
+{
+    if (path.isEmpty() || QDir::isAbsolutePath(path)) {
+        return false;
+    }
+
+    // Windows 盘符，例如 "C:foo"
+    if (path.size() >= 2 && path.at(1) == QLatin1Char(':')) {
+        return false;
+    }
+
+    const QStringList parts = path.split(QLatin1Char('/'));
+    for (const QString &part : parts) {
+        if (part == QLatin1String("..")) {
+            return false;
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
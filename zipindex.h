@@ -0,0 +1,87 @@
+#ifndef ZIPINDEX_H
+#define ZIPINDEX_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+// 中央目录中的一个条目
+struct ZipEntry
+{
+    QString filePath;
+    bool isDir;
+    quint16 method;
+    quint32 crc32;
+    qint64 compressedSize;
+    qint64 uncompressedSize;
+    qint64 localHeaderOffset;
+    qint64 dataOffset;      // 压缩数据在压缩包中的起始偏移（跳过本地文件头）
+    QByteArray contentHash; // 解压后内容的 BLAKE2b-128，只有安装清单提供
+    int firstFrame;         // 分帧格式中第一帧在帧表里的序号，ZIP 条目为 -1
+    int index;              // 条目在安装包中的序号，断点续装的日志按它记录
+};
+
+// 分帧格式的帧表：每个文件切成 frameSize 大小的帧分别压缩，可以单独解压任意一帧
+struct FrameTable
+{
+    int frameSize = 0;
+    QVector<quint32> sizes;     // 压缩后大小，最高位表示该帧未压缩
+    QVector<qint64> offsets;    // 帧数据在载荷中的偏移
+
+    static const quint32 STORED_FLAG = 0x80000000u;
+
+    qint64 compressedSize(int frame) const { return sizes.at(frame) & ~STORED_FLAG; }
+    bool isStored(int frame) const { return sizes.at(frame) & STORED_FLAG; }
+    int frameCount(qint64 uncompressedSize) const
+    {
+        return int((uncompressedSize + frameSize - 1) / frameSize);
+    }
+};
+
+// 直接解析 ZIP 中央目录（支持 ZIP64），不依赖 QZipReader，
+// 解压时可以按条目拿到压缩数据的位置，配合映射视图流式读取
+class ZipIndex
+{
+public:
+    ZipIndex();
+
+    bool load(QIODevice *archive);
+    const QVector<ZipEntry> &entries() const;
+
+    // 从 append_zip.py 写入的安装清单加载，不需要读取压缩包本身
+    bool loadManifest(const QByteArray &manifest, qint64 archiveSize);
+
+    // 分帧格式（清单版本 2）的帧表，ZIP 载荷为空
+    bool isFramed() const;
+    const FrameTable &frames() const;
+
+    // 条目路径不能是绝对路径，也不能包含 ".."，防止写出安装目录
+    static bool isSafePath(const QString &path);
+
+    static const quint16 METHOD_STORED = 0;
+    static const quint16 METHOD_DEFLATED = 8;
+    static const quint16 METHOD_LZ4_FRAMES = 0x4c34;   // 分帧格式中的 LZ4 条目
+
+    static const int MANIFEST_VERSION = 1;
+    static const int FRAMED_MANIFEST_VERSION = 2;
+
+    // 分帧载荷以魔术字符串开头，之后是紧密排列的各帧
+    static const char FRAMED_PAYLOAD_MAGIC[];
+    static const int FRAMED_PAYLOAD_HEADER_SIZE = 8;
+    static const int MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+private:
+    bool readEndOfCentralDirectory(QIODevice *archive, qint64 &centralDirOffset,
+                                   qint64 &centralDirSize, qint64 &totalEntries);
+    bool readCentralDirectory(QIODevice *archive, qint64 centralDirOffset,
+                              qint64 centralDirSize, qint64 totalEntries);
+    bool resolveDataOffsets(QIODevice *archive);
+    bool readFrameTable(const uchar *data, qint64 size, qint64 archiveSize);
+
+    QVector<ZipEntry> m_entries;
+    FrameTable m_frames;
+};
+
+#endif // ZIPINDEX_H
\ No newline at end of file